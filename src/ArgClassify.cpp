@@ -0,0 +1,163 @@
+#include "ArgClassify.h"
+//--
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+//--
+#include "ArgUsage.h"
+
+
+/// The ARG_TOKEN_EQUALS and ARG_TOKEN_INVALID bits of the bytes s[0, n).
+static uint8_t scanArgBytes(const char* s, size_t n){
+    uint8_t ret = 0;
+    size_t i = 0;
+#if defined(__SSE2__)
+    //Valid bytes are '!'..'~'.  As signed chars everything >= 0x80 is negative, so one
+    //signed compare at each end catches control characters, spaces and non-ASCII bytes.
+    const __m128i low    = _mm_set1_epi8(' ' + 1);
+    const __m128i high   = _mm_set1_epi8('~');
+    const __m128i equals = _mm_set1_epi8('=');
+    for(; i + 16 <= n; i += 16){
+        const __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+        const __m128i bad = _mm_or_si128(_mm_cmplt_epi8(v, low), _mm_cmpgt_epi8(v, high));
+        if(_mm_movemask_epi8(bad) != 0){
+            ret |= ARG_TOKEN_INVALID;
+        }
+        if(_mm_movemask_epi8(_mm_cmpeq_epi8(v, equals)) != 0){
+            ret |= ARG_TOKEN_EQUALS;
+        }
+    }
+#endif
+    for(; i < n; i++){
+        const unsigned char c = (unsigned char)s[i];
+        if(c <= ' ' || c > '~'){
+            ret |= ARG_TOKEN_INVALID;
+        }else if(c == '='){
+            ret |= ARG_TOKEN_EQUALS;
+        }
+    }
+    return ret;
+}
+
+const char* findArgByte(const char* first, const char* last, char c){
+#if defined(__SSE2__)
+    const __m128i target = _mm_set1_epi8(c);
+    for(; last - first >= 16; first += 16){
+        const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)first), target));
+        if(mask != 0){
+            return first + __builtin_ctz((unsigned)mask);
+        }
+    }
+#endif
+    for(; first != last; first++){
+        if(*first == c){
+            return first;
+        }
+    }
+    return last;
+}
+
+size_t countArgByte(const char* first, const char* last, char c){
+    size_t ret = 0;
+#if defined(__SSE2__)
+    const __m128i target = _mm_set1_epi8(c);
+    for(; last - first >= 16; first += 16){
+        const unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)first), target));
+        ret += (size_t)__builtin_popcount(mask);
+    }
+#endif
+    for(; first != last; first++){
+        ret += *first == c ? 1 : 0;
+    }
+    return ret;
+}
+
+static inline bool isDigit(char c){ return c >= '0' && c <= '9'; }
+
+/// The ARG_TOKEN_DASHED, ARG_TOKEN_HELP and ARG_TOKEN_NUMERIC bits, which only depend on the
+/// first few bytes of "tok."
+static uint8_t classifyArgTokenStart(std::string_view tok){
+    uint8_t ret = 0;
+    if(tok.empty()){
+        return ret;
+    }
+    if(tok[0] == '-'){
+        ret |= ARG_TOKEN_DASHED;
+        //Help tokens are short and all start with '-'
+        if(tok.size() <= 6 && isHelpStr(tok)){
+            ret |= ARG_TOKEN_HELP;
+        }
+    }
+    const size_t digit = (tok[0] == '-' || tok[0] == '+') ? 1 : 0;
+    if(digit < tok.size() && (isDigit(tok[digit]) ||
+        (tok[digit] == '.' && digit + 1 < tok.size() && isDigit(tok[digit + 1])))){
+        ret |= ARG_TOKEN_NUMERIC;
+    }
+    return ret;
+}
+
+uint8_t classifyArgToken(std::string_view tok){
+    return scanArgBytes(tok.data(), tok.size()) | classifyArgTokenStart(tok);
+}
+
+/// Add the ARG_TOKEN_EQUALS and ARG_TOKEN_INVALID bits of tokens[0, numTokens) to their classes.
+/// Each token must start one byte after the end of the one before it, so all of their bytes
+/// are scanned in one pass and each interesting byte is handed to the token it falls in.  The
+/// byte between two tokens(argv's '\0') belongs to neither.
+static void scanArgRun(const std::string_view* tokens, size_t numTokens, uint8_t* classes){
+    const char* const base = tokens[0].data();
+    const size_t n = (size_t)(tokens[numTokens - 1].data() + tokens[numTokens - 1].size() - base);
+    size_t tok = 0;
+    size_t tokEnd = tokens[0].size(); //Offset of the byte just past token "tok"
+    auto mark = [&](size_t pos, uint8_t bit){
+        while(pos > tokEnd){
+            ++tok;
+            tokEnd = (size_t)(tokens[tok].data() + tokens[tok].size() - base);
+        }
+        if(pos < tokEnd){
+            classes[tok] |= bit;
+        }
+    };
+    size_t i = 0;
+#if defined(__SSE2__)
+    //Same bytes as scanArgBytes
+    const __m128i low    = _mm_set1_epi8(' ' + 1);
+    const __m128i high   = _mm_set1_epi8('~');
+    const __m128i equals = _mm_set1_epi8('=');
+    for(; i + 16 <= n; i += 16){
+        const __m128i v = _mm_loadu_si128((const __m128i*)(base + i));
+        const unsigned bad = (unsigned)_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmplt_epi8(v, low), _mm_cmpgt_epi8(v, high)));
+        const unsigned eq = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, equals));
+        for(unsigned m = bad | eq; m != 0; m &= m - 1){
+            const unsigned b = (unsigned)__builtin_ctz(m);
+            mark(i + b, ((bad >> b) & 1) ? ARG_TOKEN_INVALID : ARG_TOKEN_EQUALS);
+        }
+    }
+#endif
+    for(; i < n; i++){
+        const unsigned char c = (unsigned char)base[i];
+        if(c <= ' ' || c > '~'){
+            mark(i, ARG_TOKEN_INVALID);
+        }else if(c == '='){
+            mark(i, ARG_TOKEN_EQUALS);
+        }
+    }
+}
+
+void classifyArgTokens(const std::string_view* tokens, size_t numTokens, uint8_t* classes){
+    size_t i = 0;
+    while(i < numTokens){
+        //Tokens that lie back to back, like argv as the kernel lays it out, are one run
+        size_t end = i + 1;
+        while(end < numTokens &&
+            tokens[end].data() == tokens[end - 1].data() + tokens[end - 1].size() + 1){
+            ++end;
+        }
+        for(size_t j = i; j < end; j++){
+            classes[j] = classifyArgTokenStart(tokens[j]);
+        }
+        scanArgRun(tokens + i, end - i, classes + i);
+        i = end;
+    }
+}
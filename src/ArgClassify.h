@@ -0,0 +1,55 @@
+#ifndef ARG_CLASSIFY_H
+#define ARG_CLASSIFY_H
+
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ *  Bits describing what a token looks like.  CommandLineParser classifies every token once, at
+ *  the start of a parse, and the matching loop works from the classes instead of going back to
+ *  the text: the help scan is a test of one bit, and tokens whose class no argument name shares
+ *  (a number when no name looks like one, say) skip the name lookup altogether.
+ */
+enum ArgTokenClass{
+    ARG_TOKEN_HELP    = 1 << 0, //One of the HELP_STRS(see ArgUsage.h)
+    ARG_TOKEN_DASHED  = 1 << 1, //Starts with '-', so it may be an option
+    ARG_TOKEN_NUMERIC = 1 << 2, //Starts like a number: an optional sign, then a digit or ".digit"
+    ARG_TOKEN_EQUALS  = 1 << 3, //Contains '='
+    ARG_TOKEN_INVALID = 1 << 4  //Contains a character that is not allowed in a name(see isValidArgString)
+};
+
+/**
+ *  @return the ArgTokenClass bits of "tok."
+ */
+uint8_t classifyArgToken(std::string_view tok);
+
+/**
+ *  Classify "numTokens" tokens into classes[0, numTokens).  Tokens that lie back to back in
+ *  memory, one byte apart(argv as the kernel lays it out, or the tokens of a response file
+ *  split on single separators), are scanned as one run: a single pass over all of their bytes
+ *  instead of one short scan per token.  Other tokens form runs of their own.
+ */
+void classifyArgTokens(const std::string_view* tokens, size_t numTokens, uint8_t* classes);
+
+/**
+ *  @return the first occurrence of "c" in [first, last), or last if there is none.  Like
+ *   memchr, but inline-able and without the call overhead on the short runs between the
+ *   separators of a list.
+ */
+const char* findArgByte(const char* first, const char* last, char c);
+
+/**
+ *  @return the number of occurrences of "c" in [first, last).
+ */
+size_t countArgByte(const char* first, const char* last, char c);
+
+/**
+ *  Same as isValidArgString(see ArgUsage.h), but checks 16 bytes at a time where SSE2 is
+ *  available.  isValidArgString stays constexpr for StaticSchema.
+ */
+inline bool isValidArgName(std::string_view name){
+    return (classifyArgToken(name) & ARG_TOKEN_INVALID) == 0;
+}
+
+#endif //ARG_CLASSIFY_H
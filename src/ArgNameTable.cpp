@@ -0,0 +1,65 @@
+#include "ArgNameTable.h"
+
+//Start with room for 8 names; the table is resized so that it is never more than half full
+static const size_t MIN_CAPACITY = 16;
+
+ArgNameTable::ArgNameTable() : count(0) {}
+
+void ArgNameTable::grow(){
+    std::vector<Slot> old;
+    old.swap(slots);
+
+    Slot empty;
+    empty.hash  = 0;
+    empty.index = -1;
+    slots.assign(old.empty() ? MIN_CAPACITY : old.size() * 2, empty);
+
+    const size_t mask = slots.size() - 1;
+    for(size_t i = 0; i < old.size(); i++){
+        if(old[i].index < 0){
+            continue;
+        }
+        size_t pos = (size_t)old[i].hash & mask;
+        while(slots[pos].index >= 0){
+            pos = (pos + 1) & mask;
+        }
+        slots[pos].hash  = old[i].hash;
+        slots[pos].index = old[i].index;
+        slots[pos].key.swap(old[i].key);
+    }
+}
+
+bool ArgNameTable::insert(std::string_view name, int index){
+    if(find(name) >= 0){
+        return false;
+    }
+    if((count + 1) * 2 > slots.size()){
+        grow();
+    }
+
+    const uint64_t h = hash(name);
+    const size_t mask = slots.size() - 1;
+    size_t pos = (size_t)h & mask;
+    while(slots[pos].index >= 0){
+        pos = (pos + 1) & mask;
+    }
+    slots[pos].hash  = h;
+    slots[pos].index = index;
+    slots[pos].key.assign(name.data(), name.size());
+    ++count;
+    return true;
+}
+
+int ArgNameTable::find(std::string_view name)const{
+    if(slots.empty()){
+        return -1;
+    }
+    const uint64_t h = hash(name);
+    const size_t mask = slots.size() - 1;
+    for(size_t pos = (size_t)h & mask; slots[pos].index >= 0; pos = (pos + 1) & mask){
+        if(slots[pos].hash == h && slots[pos].key == name){
+            return slots[pos].index;
+        }
+    }
+    return -1;
+}
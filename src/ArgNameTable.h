@@ -0,0 +1,60 @@
+#ifndef ARG_NAME_TABLE_H
+#define ARG_NAME_TABLE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ *  Open-addressing(linear probing) hash table that maps argument names to their index in
+ *  CommandLineParser's ordered argument list.  The table is filled in once, as arguments are
+ *  appended, so that parse() can resolve a token to an argument with a single hash and, in
+ *  the common case, a single string compare.  Lookups never allocate.
+ */
+class ArgNameTable{
+public:
+    ArgNameTable();
+
+    /**
+     *  Add a name.  Returns false(and changes nothing) if the name is already present.
+     *  @param name is the argument name.
+     *  @param index is the value returned by find(name).  Must be >= 0.
+     */
+    bool insert(std::string_view name, int index);
+
+    /**
+     *  @return the index stored for "name," or -1 if the name is not in the table.
+     */
+    int find(std::string_view name)const;
+
+    inline bool contains(std::string_view name)const{ return find(name) >= 0; }
+    inline size_t size()const{ return count; }
+
+    /**
+     *  64 bit FNV-1a hash of a string.  constexpr so that compile-time schemas(see StaticSchema.h)
+     *  can build their dispatch tables with the same function.
+     */
+    static constexpr uint64_t hash(std::string_view str){
+        uint64_t h = 14695981039346656037ULL;
+        for(size_t i = 0; i < str.size(); i++){
+            h ^= (unsigned char)str[i];
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+
+private:
+    struct Slot{
+        uint64_t hash;
+        std::string key;
+        int index; //-1 marks an empty slot
+    };
+    std::vector<Slot> slots; //Size is always zero or a power of two
+    size_t count;
+
+    void grow();
+};
+
+#endif //ARG_NAME_TABLE_H
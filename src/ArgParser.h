@@ -2,20 +2,117 @@
 #define ARG_PARSER_H
 
 #include <string>
+#include <string_view>
 #include <list>
+#include <vector>
+#include <mutex>
+#include <cstddef>
 
 /**
- *  Pure-virtual base class with one method, parseArg.  To parse custom types on the command line
+ *  Non-owning, forward-only cursor over the command line arguments that are left to parse.
+ *  Each token is a std::string_view into storage(usually argv) that outlives the parse, so
+ *  walking the command line never copies argument text.
+ */
+class ArgCursor{
+public:
+    /**
+     *  Create a cursor over the half open range [first, last).
+     */
+    ArgCursor(const std::string_view* first, const std::string_view* last) :
+        curr(first), last(last), errorText(true) {}
+
+    inline bool empty()const{ return curr == last; }
+    inline size_t size()const{ return (size_t)(last - curr); }
+
+    /**
+     *  The next unparsed token.  Only valid if !empty().
+     */
+    inline std::string_view front()const{ return *curr; }
+
+    /**
+     *  Mark the front token as consumed.  Only valid if !empty().
+     */
+    inline void popFront(){ ++curr; }
+
+    inline const std::string_view* begin()const{ return curr; }
+    inline const std::string_view* end()const{ return last; }
+
+    /**
+     *  Whether the caller wants "err" filled in when parsing fails.  CommandLineParser::parse
+     *  records errors as ParseErrorRecords and only formats them on request, so it turns this
+     *  off.  A parser may then fail WITHOUT setting err, which means "the last token I consumed
+     *  is not a valid value," and skip building the message.  Parsers are free to ignore this
+     *  and always set err.
+     */
+    inline bool wantsErrorText()const{ return errorText; }
+    inline void setWantsErrorText(bool wanted){ errorText = wanted; }
+
+private:
+    const std::string_view* curr;
+    const std::string_view* last;
+    bool errorText;
+};
+
+/**
+ *  Base class with one method, parseArg.  To parse custom types on the command line
  *  you should subclass ArgParser.  However, in many situations it may be simpler to define a stream
  *  extraction operator for your custom type "Foo", and then use a GenericParser<Foo> (see
  *  IncludedArgParsers.h for details).
  *
  *  However, for complex parsing, subclassing ArgParser is the reccomended solution.
+ *
+ *  parseArg comes in two flavors.  The ArgCursor version is what CommandLineParser calls and
+ *  does not copy any argument text.  The std::list<std::string> version is the original
+ *  interface and is kept for backwards compatibility.  Each one has a default implementation
+ *  that forwards to the other, so a subclass must override AT LEAST ONE of them(a parser that
+ *  overrides neither fails every call with an error, rather than recursing forever).  New parsers
+ *  should override the ArgCursor version; old parsers that only override the list version keep
+ *  working, but pay for a copy of the remaining arguments on every call.
+ *
+ *  Thread safety: a single ArgParser is shared by every CommandLineParser(and every copy of one)
+ *  it was appended to, and CommandLineParser::parseBatch calls it from several threads at once.
+ *  parseArg and validateArg must therefore be safe to call concurrently on the same object; in
+ *  practice this means they should not modify any member data.  All of the parsers in
+ *  IncludedArgParsers.h satisfy this.
  */
 class ArgParser{
 public:
+    virtual ~ArgParser(){}
+
+    /**
+     *  This function is called to parse command line arguments.  Any argument that is processed should be
+     *  consumed from the front of the "args" cursor via ArgCursor::popFront().  The data
+     *  pointed to at placeResultHere should be modified by this call.  If there is an error, modify the "err"
+     *  reference variable.
+     *
+     *  @param args is a cursor over the current command line arguments being parsed(left to right).
+     *  @param placeResultHere is where the results should go.  It's up to the implementation to cast this pointer
+     *   appropriately.
+     *  @param err is only modified in the event of an error.  Modify "err" to describe what happened.
+     *  @return true on success, false on failure.
+     */
+    virtual bool parseArg(ArgCursor& args, void* placeResultHere, std::string& err)const{
+        //If the list version is the default too, it calls straight back into this one
+        if(forwardingParser() == this){
+            err = "ArgParser implements neither parseArg overload.";
+            return false;
+        }
+        std::list<std::string> copied(args.begin(), args.end());
+        const size_t before = copied.size();
+        struct Forwarding{ //Restores the outer parser even if parseArg throws
+            const ArgParser* outer;
+            explicit Forwarding(const ArgParser* p) : outer(forwardingParser()){ forwardingParser() = p; }
+            ~Forwarding(){ forwardingParser() = outer; }
+        } forwarding(this);
+        const bool ret = parseArg(copied, placeResultHere, err);
+        for(size_t i = copied.size(); i < before; i++){
+            args.popFront();
+        }
+        return ret;
+    }
+
     /**
-     *  This function is called to parse command line arguments.  Any argument that is processed should be REMOVED
+     *  Legacy interface.  Any argument that is processed should be REMOVED
      *  from the front of the "args" list.  This list is mutable since its passed by reference.  The data
      *  pointed to at placeResultHere should be modified by this call.  If there is an error, modify the "err"
      *  reference variable.
@@ -26,7 +123,40 @@ public:
      *  @param err is only modified in the event of an error.  Modify "err" to describe what happened.
      *  @return true on success, false on failure.
      */
-    virtual bool parseArg(std::list<std::string>& args, void* placeResultHere, std::string& err)const = 0;
+    virtual bool parseArg(std::list<std::string>& args, void* placeResultHere, std::string& err)const{
+        std::vector<std::string_view> views(args.begin(), args.end());
+        ArgCursor cursor(views.data(), views.data() + views.size());
+        const bool ret = parseArg(cursor, placeResultHere, err);
+        for(size_t i = cursor.size(); i < views.size(); i++){
+            args.pop_front();
+        }
+        return ret;
+    }
+
+    /**
+     *  Check that the front of "args" can be parsed, consuming the same arguments parseArg would,
+     *  WITHOUT storing the result.  This is what CommandLineParser::parseBatch calls, since many
+     *  command lines are checked at once and they can't all be written to the same variables.
+     *
+     *  ArgParser doesn't know the type of the result, so the default implementation can't convert
+     *  into a temporary.  It calls parseArg, which WRITES to placeResultHere, while holding a lock
+     *  shared by all parsers: the result is correct, but validation is serialized and the
+     *  variable is modified, even by the const CommandLineParser::parseBatch.  Override this to
+     *  convert into a temporary(as every parser in IncludedArgParsers.h does) so that
+     *  validation never touches placeResultHere.
+     */
+    virtual bool validateArg(ArgCursor& args, void* placeResultHere, std::string& err)const{
+        static std::mutex lock;
+        std::lock_guard<std::mutex> guard(lock);
+        return parseArg(args, placeResultHere, err);
+    }
+
+private:
+    //The parser whose ArgCursor parseArg is forwarding to its list version on this thread
+    static const ArgParser*& forwardingParser(){
+        static thread_local const ArgParser* parser = NULL;
+        return parser;
+    }
 };
 
 #endif //ARG_PARSER_H
@@ -0,0 +1,78 @@
+#include "ArgRules.h"
+//--
+#include "ParseErrors.h"
+
+
+ArgRules::ArgRules() : numWords(0) {}
+
+ArgRules::Row& ArgRules::row(size_t arg){
+    if(arg >= rowOf.size()){
+        rowOf.resize(arg + 1, -1);
+    }
+    if(rowOf[arg] < 0){
+        rowOf[arg] = (int)rows.size();
+        Row r;
+        r.arg       = arg;
+        r.firstWord = words.size();
+        rows.push_back(r);
+        words.resize(words.size() + 2 * numWords, 0);
+    }
+    return rows[rowOf[arg]];
+}
+
+void ArgRules::setBit(size_t arg, size_t other, bool excluded){
+    //Widen every mask if "other" doesn't fit yet
+    const size_t needed = other / 64 + 1;
+    if(needed > numWords){
+        std::vector<uint64_t> wider(rows.size() * 2 * needed, 0);
+        for(size_t i = 0; i < rows.size(); i++){
+            for(size_t w = 0; w < 2 * numWords; w++){
+                const size_t mask = w / numWords;
+                wider[i * 2 * needed + mask * needed + w % numWords] = words[rows[i].firstWord + w];
+            }
+            rows[i].firstWord = i * 2 * needed;
+        }
+        words.swap(wider);
+        numWords = needed;
+    }
+    const Row& r = row(arg);
+    words[r.firstWord + (excluded ? numWords : 0) + other / 64] |= (uint64_t)1 << (other % 64);
+}
+
+void ArgRules::addDependency(size_t arg, size_t required){
+    setBit(arg, required, false);
+}
+
+void ArgRules::addExclusion(size_t a, size_t b){
+    //One direction is enough, and reports each conflict once
+    setBit(a, b, true);
+}
+
+bool ArgRules::check(const uint64_t* present, ParseErrors& errors)const{
+    bool ok = true;
+    for(size_t i = 0; i < rows.size(); i++){
+        const Row& r = rows[i];
+        if(((present[r.arg / 64] >> (r.arg % 64)) & 1) == 0){
+            continue;
+        }
+        const uint64_t* required = &words[r.firstWord];
+        const uint64_t* excluded = required + numWords;
+        for(size_t w = 0; w < numWords; w++){
+            uint64_t missing  = required[w] & ~present[w];
+            uint64_t conflict = excluded[w] & present[w];
+            for(size_t bit = 0; (missing | conflict) != 0; bit++, missing >>= 1, conflict >>= 1){
+                if(missing & 1){
+                    errors.add(PARSE_ERR_REQUIRES, (int)r.arg, -1, std::string_view(),
+                        std::string_view(), (int)(w * 64 + bit));
+                    ok = false;
+                }
+                if(conflict & 1){
+                    errors.add(PARSE_ERR_EXCLUDES, (int)r.arg, -1, std::string_view(),
+                        std::string_view(), (int)(w * 64 + bit));
+                    ok = false;
+                }
+            }
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,53 @@
+#ifndef ARG_RULES_H
+#define ARG_RULES_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+class ParseErrors;
+
+/**
+ *  Rules about which arguments may be given together: "X requires Y" and "X excludes Y."
+ *
+ *  The rules are compiled into one row of bits per argument that has rules: the arguments it
+ *  requires and the arguments it excludes, 64 to a word.  A parse checks them against the
+ *  bitset of the arguments that were given, so each argument with rules costs a couple of word
+ *  operations per 64 arguments, no matter how many rules it has.
+ */
+class ArgRules{
+public:
+    ArgRules();
+
+    /// If argument "arg" is given, argument "required" must be given too.
+    void addDependency(size_t arg, size_t required);
+
+    /// Arguments "a" and "b" can't both be given.
+    void addExclusion(size_t a, size_t b);
+
+    inline bool empty()const{ return rows.empty(); }
+
+    /**
+     *  Check every rule.
+     *  @param present has one bit per argument, set for the arguments that were given.  Must
+     *   cover every argument named in a rule.
+     *  @param errors receives a PARSE_ERR_REQUIRES or PARSE_ERR_EXCLUDES record per broken rule.
+     *  @return true if no rule is broken.
+     */
+    bool check(const uint64_t* present, ParseErrors& errors)const;
+
+private:
+    struct Row{
+        size_t arg;
+        size_t firstWord; //Into "words": numWords words of required bits, then numWords of excluded
+    };
+    std::vector<Row> rows;
+    std::vector<int> rowOf;       //Per argument, its index in rows or -1
+    std::vector<uint64_t> words;
+    size_t numWords;              //Words per mask
+
+    Row& row(size_t arg);
+    void setBit(size_t arg, size_t other, bool excluded);
+};
+
+#endif //ARG_RULES_H
@@ -0,0 +1,78 @@
+#include "ArgStream.h"
+//--
+#include <cstring>
+#include <cerrno>
+
+#if defined(_WIN32)
+#include <io.h>
+#define ARG_STREAM_READ _read
+#else
+#include <unistd.h>
+#define ARG_STREAM_READ ::read
+#endif
+
+
+ArgStreamReader::ArgStreamReader(int fd, Delimiter delim, size_t bufferSize) : fd(fd),
+    delim(delim), buffer(bufferSize > 0 ? bufferSize : 1), numDelivered(0) {}
+
+bool ArgStreamReader::run(ArgStreamSink& sink, std::string& err){
+    char* const buf = buffer.data();
+    const size_t capacity = buffer.size();
+    size_t filled = 0; //buf[0, filled) holds unprocessed bytes
+    char delimChar = delim == DELIM_NUL ? '\0' : '\n';
+    bool delimKnown = delim != DELIM_AUTO;
+    bool atEnd = false;
+
+    while(! atEnd){
+        if(filled == capacity){
+            err = "Streamed argument is longer than the " + std::to_string(capacity) +
+                " byte buffer.";
+            return false;
+        }
+        const long n = (long)ARG_STREAM_READ(fd, buf + filled, (unsigned)(capacity - filled));
+        if(n < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            err = std::string("Could not read streamed arguments: ") + strerror(errno);
+            return false;
+        }
+        if(! delimKnown && n > 0){
+            delimChar  = memchr(buf + filled, '\0', (size_t)n) != NULL ? '\0' : '\n';
+            delimKnown = true;
+        }
+        atEnd   = n == 0;
+        filled += (size_t)n;
+
+        //Hand over every complete entry.  At the end of the stream the last entry does not
+        //need a delimiter.
+        size_t begin = 0;
+        while(begin < filled){
+            const char* stop = (const char*)memchr(buf + begin, delimChar, filled - begin);
+            if(stop == NULL && ! atEnd){
+                break;
+            }
+            const size_t end = stop == NULL ? filled : (size_t)(stop - buf);
+            std::string_view entry(buf + begin, end - begin);
+            if(delimChar == '\n' && ! entry.empty() && entry.back() == '\r'){
+                entry.remove_suffix(1);
+            }
+            if(! entry.empty()){
+                if(! sink.consume(entry, numDelivered, err)){
+                    return false;
+                }
+                ++numDelivered;
+            }
+            begin = end + 1;
+        }
+
+        //Move the partial entry to the front of the buffer
+        if(begin >= filled){
+            filled = 0;
+        }else if(begin > 0){
+            memmove(buf, buf + begin, filled - begin);
+            filled -= begin;
+        }
+    }
+    return true;
+}
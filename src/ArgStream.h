@@ -0,0 +1,106 @@
+#ifndef ARG_STREAM_H
+#define ARG_STREAM_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+//--
+#include "ArgParser.h"
+
+/**
+ *  Receives the arguments read by an ArgStreamReader, one at a time, as they arrive.
+ *  Subclass TypedArgStreamSink rather than this class to have each value run through an
+ *  ArgParser first.
+ */
+class ArgStreamSink{
+public:
+    virtual ~ArgStreamSink(){}
+
+    /**
+     *  Called once per argument, in stream order.
+     *  @param token is the argument text.  Only valid for the duration of the call.
+     *  @param index is the position of the argument in the stream, starting at 0.
+     *  @param err should describe what went wrong on failure.
+     *  @return true to keep reading, false to stop with an error.
+     */
+    virtual bool consume(std::string_view token, size_t index, std::string& err) = 0;
+};
+
+/**
+ *  An ArgStreamSink that converts each argument to a T with an ArgParser, and hands the
+ *  value to onValue.  A single T is reused for every argument.
+ */
+template<typename T>
+class TypedArgStreamSink : public ArgStreamSink{
+public:
+    explicit TypedArgStreamSink(const ArgParser* parser) : parser(parser) {}
+
+    /**
+     *  Called with each converted argument.
+     *  @return true to keep reading, false to stop with an error(described in err).
+     */
+    virtual bool onValue(const T& value, size_t index, std::string& err) = 0;
+
+    virtual bool consume(std::string_view token, size_t index, std::string& err){
+        ArgCursor cursor(&token, &token + 1);
+        if(! parser->parseArg(cursor, (void*)&value, err)){
+            if(err.empty()){
+                err = "Parse error on argument: \"" + std::string(token) + "\"";
+            }
+            return false;
+        }
+        return onValue(value, index, err);
+    }
+
+private:
+    const ArgParser* parser;
+    T value;
+};
+
+/**
+ *  Reads delimited arguments from a file descriptor(usually a pipe on stdin, as in
+ *  "find . -print0 | tool") and feeds them to an ArgStreamSink as they arrive.
+ *
+ *  Memory use is one fixed size buffer, no matter how many arguments there are, and the first
+ *  argument is delivered as soon as it has been read rather than when the producer finishes.
+ *  An argument longer than the buffer is an error.
+ */
+class ArgStreamReader{
+public:
+    enum Delimiter{
+        DELIM_AUTO,    //NUL if the first read contains a NUL byte, otherwise newline
+        DELIM_NUL,     //As written by "find -print0" and "xargs -0"
+        DELIM_NEWLINE  //One argument per line.  A trailing carriage return is dropped.
+    };
+
+    static const size_t DEFAULT_BUFFER_SIZE = 64 << 10;
+
+    /**
+     *  @param fd is the file descriptor to read.  It is not closed.
+     *  @param delim says how arguments are separated.  Empty arguments are skipped.
+     *  @param bufferSize is the size of the read buffer, and so the longest argument allowed.
+     */
+    ArgStreamReader(int fd, Delimiter delim = DELIM_AUTO, size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+    /**
+     *  Read to the end of the stream, handing each argument to "sink."
+     *  @param err describes what went wrong on failure.
+     *  @return true on success, false if reading failed, an argument was too long, or the
+     *   sink returned false.
+     */
+    bool run(ArgStreamSink& sink, std::string& err);
+
+    /**
+     *  @return the number of arguments delivered to the sink so far.
+     */
+    inline size_t count()const{ return numDelivered; }
+
+private:
+    int fd;
+    Delimiter delim;
+    std::vector<char> buffer;
+    size_t numDelivered;
+};
+
+#endif //ARG_STREAM_H
@@ -0,0 +1,140 @@
+#include "ArgTrie.h"
+//--
+#include <algorithm>
+
+
+ArgTrie::ArgTrie() : count(0) {
+    Node root = {0, 0, -1, NONE, NONE};
+    nodes.push_back(root);
+}
+
+uint32_t ArgTrie::findChild(uint32_t node, char c)const{
+    for(uint32_t child = nodes[node].firstChild; child != NONE; child = nodes[child].nextSibling){
+        const unsigned char first = (unsigned char)labels[nodes[child].labelBegin];
+        if(first == (unsigned char)c){
+            return child;
+        }else if(first > (unsigned char)c){
+            break;
+        }
+    }
+    return NONE;
+}
+
+void ArgTrie::insert(std::string_view key, int value){
+    uint32_t node = 0;
+    size_t pos = 0;
+    while(pos < key.size()){
+        const uint32_t child = findChild(node, key[pos]);
+        if(child == NONE){
+            //A new leaf holding the rest of the key, linked in sorted order
+            Node leaf = {(uint32_t)labels.size(), (uint32_t)(key.size() - pos), value, NONE, NONE};
+            labels.append(key.data() + pos, key.size() - pos);
+            const uint32_t leafIdx = (uint32_t)nodes.size();
+            uint32_t* link = &nodes[node].firstChild;
+            while(*link != NONE && (unsigned char)labels[nodes[*link].labelBegin] < (unsigned char)key[pos]){
+                link = &nodes[*link].nextSibling;
+            }
+            leaf.nextSibling = *link;
+            nodes.push_back(leaf);
+            //push_back may have moved the nodes, so find the link again
+            link = &nodes[node].firstChild;
+            while(*link != leaf.nextSibling){
+                link = &nodes[*link].nextSibling;
+            }
+            *link = leafIdx;
+            ++count;
+            return;
+        }
+
+        //Length of the common prefix of the child's label and the rest of the key
+        const Node& c = nodes[child];
+        size_t k = 0;
+        while(k < c.labelLen && pos + k < key.size() && labels[c.labelBegin + k] == key[pos + k]){
+            ++k;
+        }
+        if(k < c.labelLen){
+            //Split the edge: a new node takes the common part, and the child keeps the rest
+            Node mid = {c.labelBegin, (uint32_t)k, -1, child, c.nextSibling};
+            const uint32_t midIdx = (uint32_t)nodes.size();
+            nodes.push_back(mid);
+            nodes[child].labelBegin += (uint32_t)k;
+            nodes[child].labelLen   -= (uint32_t)k;
+            nodes[child].nextSibling = NONE;
+            uint32_t* link = &nodes[node].firstChild;
+            while(*link != child){
+                link = &nodes[*link].nextSibling;
+            }
+            *link = midIdx;
+            node = midIdx;
+        }else{
+            node = child;
+        }
+        pos += k;
+    }
+    if(nodes[node].value < 0){
+        ++count;
+    }
+    nodes[node].value = value;
+}
+
+int ArgTrie::find(std::string_view key)const{
+    uint32_t node = 0;
+    size_t pos = 0;
+    while(pos < key.size()){
+        node = findChild(node, key[pos]);
+        if(node == NONE){
+            return -1;
+        }
+        const Node& n = nodes[node];
+        if(key.size() - pos < n.labelLen || key.compare(pos, n.labelLen, labels, n.labelBegin, n.labelLen) != 0){
+            return -1;
+        }
+        pos += n.labelLen;
+    }
+    return nodes[node].value;
+}
+
+uint32_t ArgTrie::findPrefixNode(std::string_view prefix)const{
+    uint32_t node = 0;
+    size_t pos = 0;
+    while(pos < prefix.size()){
+        node = findChild(node, prefix[pos]);
+        if(node == NONE){
+            return NONE;
+        }
+        const Node& n = nodes[node];
+        const size_t len = std::min<size_t>(n.labelLen, prefix.size() - pos);
+        if(prefix.compare(pos, len, labels, n.labelBegin, len) != 0){
+            return NONE;
+        }
+        pos += len; //If the prefix ends inside this label, every key below "node" matches
+    }
+    return node;
+}
+
+size_t ArgTrie::findPrefix(std::string_view prefix, std::vector<int>& values, size_t maxValues)const{
+    const uint32_t node = findPrefixNode(prefix);
+    return node == NONE ? 0 : collect(node, &values, NULL, maxValues);
+}
+
+size_t ArgTrie::findPrefix(std::string_view prefix, int* values, size_t maxValues)const{
+    const uint32_t node = findPrefixNode(prefix);
+    return node == NONE ? 0 : collect(node, NULL, values, maxValues);
+}
+
+size_t ArgTrie::collect(uint32_t node, std::vector<int>* vec, int* array, size_t maxValues)const{
+    size_t found = 0;
+    if(found < maxValues && nodes[node].value >= 0){
+        if(vec != NULL){
+            vec->push_back(nodes[node].value);
+        }else{
+            array[found] = nodes[node].value;
+        }
+        ++found;
+    }
+    for(uint32_t child = nodes[node].firstChild; child != NONE && found < maxValues;
+        child = nodes[child].nextSibling){
+        found += collect(child, vec, array == NULL ? NULL : array + found, maxValues - found);
+    }
+    return found;
+}
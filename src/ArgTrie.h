@@ -0,0 +1,74 @@
+#ifndef ARG_TRIE_H
+#define ARG_TRIE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ *  Compressed(radix) prefix trie from strings to ints.  CommandLineParser builds one over
+ *  the argument names(and one per set of completion choices) as arguments are appended, so
+ *  that every name starting with a given prefix can be found without scanning them all.
+ *  Used by shell completion and by abbreviated option names.
+ *
+ *  Each edge holds a run of characters, stored as a range of one shared label string, and
+ *  nodes live in a single vector; building the trie makes a handful of allocations in total
+ *  and lookups make none(other than growing the output vector).
+ */
+class ArgTrie{
+public:
+    ArgTrie();
+
+    /**
+     *  Add a key.  If the key is already present its value is replaced.
+     *  @param value must be >= 0.
+     */
+    void insert(std::string_view key, int value);
+
+    /**
+     *  @return the value stored for exactly "key," or -1 if there is none.
+     */
+    int find(std::string_view key)const;
+
+    /**
+     *  Append the value of every key that starts with "prefix" to "values," in lexicographic
+     *  order of the keys.
+     *  @param maxValues stops the search once this many values have been appended.
+     *  @return the number of values appended.
+     */
+    size_t findPrefix(std::string_view prefix, std::vector<int>& values,
+        size_t maxValues = (size_t)-1)const;
+
+    /**
+     *  Same as above, but writes at most maxValues values to values[0, maxValues), so it never
+     *  allocates.  With maxValues = 2 it tells a unique prefix from an ambiguous one.
+     */
+    size_t findPrefix(std::string_view prefix, int* values, size_t maxValues)const;
+
+    inline size_t size()const{ return count; }
+
+private:
+    static const uint32_t NONE = 0xffffffffu;
+
+    struct Node{
+        uint32_t labelBegin; //The edge into this node is labels[labelBegin, labelBegin + labelLen)
+        uint32_t labelLen;
+        int value;           //-1 if no key ends here
+        uint32_t firstChild; //Children are sorted by the first character of their label
+        uint32_t nextSibling;
+    };
+    std::string labels;
+    std::vector<Node> nodes; //nodes[0] is the root, with an empty label
+    size_t count;
+
+    /// The child of "node" whose label starts with c, or NONE.
+    uint32_t findChild(uint32_t node, char c)const;
+    /// The node below which every key starts with "prefix," or NONE.
+    uint32_t findPrefixNode(std::string_view prefix)const;
+    /// Append up to maxValues values below "node" to *vec, or write them to array if vec is NULL.
+    size_t collect(uint32_t node, std::vector<int>* vec, int* array, size_t maxValues)const;
+};
+
+#endif //ARG_TRIE_H
@@ -0,0 +1,116 @@
+#include "ArgUsage.h"
+//--
+#include <string>
+#include <vector>
+#include <iomanip>
+#include <climits>
+#include <algorithm>
+
+
+void printUsageMessage(std::ostream& os, std::string_view appName, std::string_view helpMsg,
+    const ArgUsage* args, size_t numArgs){
+
+    //String to print to indicate that something must be specified
+    const std::string BLANK_SPOT_STR("___");
+
+    //Spacing string between positional arguments and regions of named arguments
+    const std::string EXTRA_SPACING("   ");
+
+    //Determine the max number of padding characters we need so that everything
+    //lines up when printed out
+    size_t wPad = 0;
+    for(size_t i = 0; i < numArgs; i++){
+        wPad = std::max<size_t>(args[i].name.size(), wPad);
+    }
+    //the iomanip setw function takes an int as a padding size, but string length is given
+    //as a size_t type(typically unsigned)
+    //the below statement ensures that we convert size_t to int properly, even though it is
+    //totally ridiculous to assume that the max string length in our list could ever exceed INT_MAX
+    int pad = wPad > INT_MAX ? INT_MAX : (int)wPad;
+
+
+    //Print basic usage line
+    bool prevWasPositional = false;
+    int optCount = 0;
+    os << "usage: " << appName << " ";
+    if(! helpMsg.empty()){
+        ++optCount;
+        os << "[--help] ";
+        prevWasPositional = false;
+    }
+    std::vector<size_t> namedIndices, positionalIndices;
+    for(size_t i = 0; i < numArgs; i++){
+
+        //Create string to print representing the current argument
+        std::string nameStr(args[i].name);
+        if(args[i].named){
+            nameStr += " " + BLANK_SPOT_STR;
+        }
+        if(args[i].optional){
+            nameStr = "[" + nameStr + "]";
+        }
+
+        //Print the argument
+        os << nameStr << " ";
+
+        //Print extra spacing if we are moving from a region of named
+        //arguments to a region of positional arguments or vice versa
+        const bool currIsPositional = ! args[i].named;
+        if(currIsPositional ^ prevWasPositional){
+            os << EXTRA_SPACING;
+            prevWasPositional = currIsPositional;
+        }
+
+        //Add to indices lists
+        if(args[i].named){
+            namedIndices.push_back(i);
+        }else{
+            positionalIndices.push_back(i);
+        }
+
+    }
+    os << std::endl << std::endl;
+
+    //Print info on what syntax means
+    if(optCount > 0 || ! namedIndices.empty()){
+        os << "Notation: " << std::endl;
+        if(optCount > 0){
+            os << "\t[...] indicates that an argument is optional." << std::endl;
+        }
+        if(! namedIndices.empty()){
+            os << "\t" << BLANK_SPOT_STR << " indicates that a value must be placed here." << std::endl;
+        }
+        os << std::endl;
+    }
+
+    //Print short help message
+    if(! helpMsg.empty()){
+        os << helpMsg << std::endl << std::endl;
+    }
+
+    //Print off info for each type of argument
+    //    positional arguments
+    if(positionalIndices.size() > 0){
+        os << "Positional arguments: " << std::endl;
+        for(size_t i = 0; i < positionalIndices.size(); i++){
+            size_t idx = positionalIndices[i];
+            os << "\t" << std::setw(pad) << args[idx].name << "\t" <<
+                args[idx].helpTxt << std::endl;
+        }
+        os << std::endl;
+    }
+    //    named arguments
+    if(namedIndices.size() > 0){
+        os << "Named arguments: " << std::endl;
+        for(size_t i = 0; i < namedIndices.size(); i++){
+            size_t idx = namedIndices[i];
+            os << "\t" << std::setw(pad) << args[idx].name << "\t" <<
+                args[idx].helpTxt <<
+                (args[idx].optional ? "  Optional." : "  Required.") << std::endl;
+        }
+        os << std::endl << "\tNote that multiple adjacent named arguments can be " <<
+            "specified in any order." << std::endl;
+    }
+}
+
+
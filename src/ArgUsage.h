@@ -0,0 +1,63 @@
+#ifndef ARG_USAGE_H
+#define ARG_USAGE_H
+
+#include <string_view>
+#include <ostream>
+#include <cstddef>
+
+/**
+ *  Rules and formatting that are shared by every kind of parser in this library
+ *  (CommandLineParser and the compile-time StaticSchema): which tokens request help,
+ *  which strings make valid argument names, and how the help message is laid out.
+ */
+
+/**
+ *  Everything printUsageMessage needs to know about a single argument.
+ */
+struct ArgUsage{
+    std::string_view name;
+    std::string_view helpTxt;
+    bool optional;
+    bool named;
+};
+
+/// Tokens that request the help message.
+inline constexpr int NUM_HELP_ARGS = 4;
+inline constexpr std::string_view HELP_STRS[NUM_HELP_ARGS] = {"-h", "--h", "-help", "--help"};
+
+/// Return true if "str" is one of the HELP_STRS.
+constexpr bool isHelpStr(std::string_view str){
+    for(int i = 0; i < NUM_HELP_ARGS; i++){
+        if(str == HELP_STRS[i]){
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Return true if "str" is a valid argument string.  These strings
+/// can only be composed of alphanumeric characters, dashes, and punctuation.
+/// Whitespace characters and control characters are NOT allowed.
+constexpr bool isValidArgString(std::string_view str){
+    for(size_t i = 0; i < str.size(); i++){
+        //OK characters are printable non-whitespace ASCII chars
+        const unsigned char curr = (unsigned char)str[i];
+        if(curr <= ' ' || curr > '~'){
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ *  Print a help message.
+ *  @param os is the stream to print on.
+ *  @param appName is the name of the binary.  Should usually be argv[0].
+ *  @param helpMsg is the application's help text.  May be empty.
+ *  @param args is the list of arguments, in the order they were registered.
+ *  @param numArgs is the length of "args."
+ */
+void printUsageMessage(std::ostream& os, std::string_view appName, std::string_view helpMsg,
+    const ArgUsage* args, size_t numArgs);
+
+#endif //ARG_USAGE_H
@@ -0,0 +1,85 @@
+#include "ArgValueCodec.h"
+//--
+#include <cstring>
+//--
+#include "IncludedArgParsers.h"
+
+
+/// Append the bytes of a fixed size value.
+template<typename T>
+static void appendRaw(const T& value, std::string& out){
+    out.append((const char*)&value, sizeof(T));
+}
+
+/// Read back a value written by appendRaw.
+template<typename T>
+static bool readRaw(std::string_view payload, void* var){
+    if(payload.size() != sizeof(T)){
+        return false;
+    }
+    memcpy(var, payload.data(), sizeof(T));
+    return true;
+}
+
+/// Convert text through ArgValueTraits<T>, then append it.
+template<typename T>
+static bool convertAndAppend(std::string_view text, std::string& out){
+    T value;
+    if(! ArgValueTraits<T>::fromString(text, value)){
+        return false;
+    }
+    appendRaw(value, out);
+    return true;
+}
+
+void encodeArgVariable(ArgValueKind kind, const void* var, std::string& out){
+    switch(kind){
+        case ARG_KIND_INT    : appendRaw(*(const int*)var, out);          break;
+        case ARG_KIND_UINT   : appendRaw(*(const unsigned int*)var, out); break;
+        case ARG_KIND_FLOAT  : appendRaw(*(const float*)var, out);        break;
+        case ARG_KIND_DOUBLE : appendRaw(*(const double*)var, out);       break;
+        case ARG_KIND_STRING : out += *(const std::string*)var;           break;
+        case ARG_KIND_BOOL   : out += (char)(*(const bool*)var ? 1 : 0);  break;
+        default              : break;
+    }
+}
+
+bool encodeArgValue(ArgValueKind kind, std::string_view text, std::string& out){
+    switch(kind){
+        case ARG_KIND_INT    : return convertAndAppend<int>(text, out);
+        case ARG_KIND_UINT   : return convertAndAppend<unsigned int>(text, out);
+        case ARG_KIND_FLOAT  : return convertAndAppend<float>(text, out);
+        case ARG_KIND_DOUBLE : return convertAndAppend<double>(text, out);
+        case ARG_KIND_BOOL   :{
+            bool value;
+            if(! ArgValueTraits<bool>::fromString(text, value)){
+                return false;
+            }
+            out += (char)(value ? 1 : 0);
+            return true;
+        }
+        default              : //ARG_KIND_STRING and ARG_KIND_CUSTOM are kept as text
+            out.append(text.data(), text.size());
+            return true;
+    }
+}
+
+bool decodeArgValue(ArgValueKind kind, std::string_view payload, void* var){
+    switch(kind){
+        case ARG_KIND_INT    : return readRaw<int>(payload, var);
+        case ARG_KIND_UINT   : return readRaw<unsigned int>(payload, var);
+        case ARG_KIND_FLOAT  : return readRaw<float>(payload, var);
+        case ARG_KIND_DOUBLE : return readRaw<double>(payload, var);
+        case ARG_KIND_STRING :
+            ((std::string*)var)->assign(payload.data(), payload.size());
+            return true;
+        case ARG_KIND_BOOL   :
+            if(payload.size() != 1){
+                return false;
+            }
+            *(bool*)var = payload[0] != 0;
+            return true;
+        default              :
+            return false;
+    }
+}
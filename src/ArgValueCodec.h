@@ -0,0 +1,46 @@
+#ifndef ARG_VALUE_CODEC_H
+#define ARG_VALUE_CODEC_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+/**
+ *  The kinds of value the common ArgParsers(CommandLineParser::getCommonArgParser) produce.
+ *  Values of these kinds have a fixed binary form, so they can be stored already converted
+ *  (in the config cache, for example) and written straight back into a variable later.
+ *  Anything parsed by another ArgParser is ARG_KIND_CUSTOM and is stored as text.
+ *
+ *  The numeric values are part of the binary formats; only ever append to this list.
+ */
+enum ArgValueKind{
+    ARG_KIND_CUSTOM = 0,
+    ARG_KIND_INT    = 1, //int,          4 bytes
+    ARG_KIND_UINT   = 2, //unsigned int, 4 bytes
+    ARG_KIND_FLOAT  = 3, //float,        4 bytes
+    ARG_KIND_DOUBLE = 4, //double,       8 bytes
+    ARG_KIND_STRING = 5, //std::string,  the bytes of the string
+    ARG_KIND_BOOL   = 6  //bool,         1 byte
+};
+
+/**
+ *  Append the binary form of the variable "var" to "out."
+ *  @param kind says what var points to.  Must not be ARG_KIND_CUSTOM.
+ */
+void encodeArgVariable(ArgValueKind kind, const void* var, std::string& out);
+
+/**
+ *  Convert "text" the same way the common ArgParser for "kind" would, and append the binary
+ *  form of the result to "out."  ARG_KIND_CUSTOM text is appended as is.
+ *  @return true on success, false if the text does not convert.
+ */
+bool encodeArgValue(ArgValueKind kind, std::string_view text, std::string& out);
+
+/**
+ *  Write a value produced by encodeArgVariable/encodeArgValue into "var."
+ *  @param kind must not be ARG_KIND_CUSTOM.
+ *  @return false(leaving var alone) if "payload" is the wrong size for "kind."
+ */
+bool decodeArgValue(ArgValueKind kind, std::string_view payload, void* var);
+
+#endif //ARG_VALUE_CODEC_H
@@ -3,14 +3,19 @@
 #include <cctype>
 #include <iostream>
 #include <cassert>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
 #include <iomanip>
-#include <climits>
+#include <algorithm>
+#include <thread>
+#include <atomic>
 //--
 #include "IncludedArgParsers.h"
-
-//Helper data -----------------------------------------------------------------
-static const int NUM_HELP_ARGS = 4;
-static const std::string HELP_STRS[NUM_HELP_ARGS] = {"-h", "--h", "-help", "--help"};
+#include "ArgUsage.h"
+#include "ResponseFile.h"
+#include "ConfigFile.h"
 
 //Helper functions ------------------------------------------------------------
 static inline bool isWhitespace(const char x){ return isspace((int)x); }
@@ -37,132 +42,427 @@ static std::string trimWhitespaceBack(const std::string& s){
     return s.substr(0,sslen+1);
 }
 
-/// Return true if "str" is a valid argument string.  These strings
-/// can only be composed of alphanumeric characters, dashes, and punctuation.
-/// Whitespace characters and control characters are NOT allowed.
-bool isValidArgString(const std::string& str){
-    for(size_t i = 0; i < str.size(); i++){
-        const char curr = str[i];
+/// Fixed size set of bits, one per registered argument.  Parsers with up to
+/// 256 arguments keep the bits on the stack, so a parse does not allocate for them;
+/// larger ones allocate from the parse's memory resource.
+class ArgBitset{
+public:
+    ArgBitset(size_t numBits, std::pmr::memory_resource* resource) : heap(resource), words(local){
+        const size_t numWords = (numBits + 63) / 64;
+        if(numWords > NUM_LOCAL_WORDS){
+            heap.assign(numWords, 0);
+            words = heap.data();
+        }else{
+            std::fill(local, local + NUM_LOCAL_WORDS, 0);
+        }
+    }
+    inline bool test(size_t i)const{ return (words[i >> 6] >> (i & 63)) & 1; }
+    inline void set(size_t i){ words[i >> 6] |= (uint64_t)1 << (i & 63); }
+    inline const uint64_t* data()const{ return words; }
 
-        //OK characters are printable non-whitespace chars
-        bool charIsOK = isprint((int) curr) && (! isspace((int) curr));
-        if(! charIsOK){
-            return false;
+    /// The first i in [from, to) whose bit is set in "mask" but not here, or "to" if there is none.
+    size_t findMissing(const uint64_t* mask, size_t from, size_t to)const{
+        while(from < to){
+            const size_t w = from >> 6;
+            uint64_t missing = (mask[w] & ~words[w]) >> (from & 63);
+            if(missing != 0){
+                while((missing & 1) == 0){
+                    missing >>= 1;
+                    ++from;
+                }
+                return from < to ? from : to;
+            }
+            from = (w + 1) << 6;
         }
+        return to;
+    }
+private:
+    static const size_t NUM_LOCAL_WORDS = 4;
+    uint64_t local[NUM_LOCAL_WORDS];
+    std::pmr::vector<uint64_t> heap;
+    uint64_t* words;
+};
+
+/// Scratch space for a value of one of the fixed size kinds(ranged arguments are numeric).
+union NumericArgValue{
+    bool b;
+    int i;
+    unsigned int u;
+    float f;
+    double d;
+};
+
+static double numericArgValue(ArgValueKind kind, const NumericArgValue* value){
+    switch(kind){
+        case ARG_KIND_INT:
+            return value->i;
+        case ARG_KIND_UINT:
+            return value->u;
+        case ARG_KIND_FLOAT:
+            return value->f;
+        default:
+            return value->d;
     }
-    return true;
 }
 
-bool isHelpStr(const std::string& str){
-    for(int i = 0; i < NUM_HELP_ARGS; i++){
-        if(str == HELP_STRS[i]){
-            return true;
-        }
+/// Store "value" into the variable of an argument of kind "kind," through its real type.
+static void storeNumericArgValue(ArgValueKind kind, const NumericArgValue* value, void* var){
+    switch(kind){
+        case ARG_KIND_INT:
+            *(int*)var = value->i;
+            break;
+        case ARG_KIND_UINT:
+            *(unsigned int*)var = value->u;
+            break;
+        case ARG_KIND_FLOAT:
+            *(float*)var = value->f;
+            break;
+        case ARG_KIND_DOUBLE:
+            *(double*)var = value->d;
+            break;
+        default:
+            break;
     }
-    return false;
 }
 
+static bool inArgRange(const ParsePlan& plan, size_t idx, const NumericArgValue* value){
+    const double x = numericArgValue(plan.kind(idx), value);
+    return x >= plan.rangeMin(idx) && x <= plan.rangeMax(idx);
+}
+
+/// Shortest text for a bound, as in "0", "10" or "0.5"
+static std::string formatRangeBound(double x){
+    std::ostringstream os;
+    os << std::setprecision(17) << x;
+    std::string shortest = os.str();
+    os.str(std::string());
+    os << x;
+    return std::stod(os.str()) == x ? os.str() : shortest;
+}
 
 //-----------------------------------------------------------------------------
 
 
 //Method Implementations-------------------------------------------------------
 
-void CommandLineParser::initParserTable(){
-    //TODO: This will be removed in the next revision.
-    parsers[0] = new FloatArgParser();
-    parsers[1] = new DoubleArgParser();
-    parsers[2] = new IntArgParser();
-    parsers[3] = new UnsignedIntArgParser();
-    parsers[4] = new StringArgParser();
-    parsers[5] = new BoolArgParser();
-}
-
-
-const ArgParser* const CommandLineParser::getCommonArgParser(CommonParser parser)const{
-    //TODO: This will be removed in the next revision.
+const ArgParser* CommandLineParser::getCommonArgParser(CommonParser parser){
+    //Function local statics are created once, on first use, in a thread safe manner
+    static const IntArgParser         intParser;
+    static const UnsignedIntArgParser uintParser;
+    static const FloatArgParser       floatParser;
+    static const DoubleArgParser      doubleParser;
+    static const StringArgParser      stringParser;
+    static const BoolArgParser        boolParser;
     switch(parser){
         case AP_INT    :
-            return parsers[2];
+            return &intParser;
         case AP_UINT   :
-            return parsers[3];
+            return &uintParser;
         case AP_FLOAT  :
-            return parsers[0];
+            return &floatParser;
         case AP_DOUBLE :
-            return parsers[1];
+            return &doubleParser;
         case AP_STRING :
-            return parsers[4];
+            return &stringParser;
         case AP_BOOLEAN:
-            return parsers[5];
+            return &boolParser;
         default        :
             return NULL;
     }
 }
 
+CommandLineParser::Schema* CommandLineParser::mutableSchema(){
+    if(frozen){
+        return NULL;
+    }
+    if(schema.use_count() != 1){
+        schema = std::make_shared<Schema>(*schema);
+    }
+    return const_cast<Schema*>(schema.get());
+}
+
+void CommandLineParser::freeze(){
+    frozen = true;
+}
+
 bool CommandLineParser::appendArgHelper(void* argVar, const std::string argName,
-    const ArgParser* parser, const std::string helpStr, bool optional, bool named){
+    const ArgParser* parser, const std::string helpStr, bool optional, bool named, bool lazy,
+    bool list){
 
     //Positional arguments CANT be optional
     assert( named || (!optional && !named) );
 
-    if(!isArgumentNameOK(argName)){
+    if(frozen || !isArgumentNameOK(argName)){
         return false;
     }else{
+        Schema* sch = mutableSchema();
         struct Arg arg;
         arg.var      = argVar;
         arg.name     = argName;
         arg.parser   = parser;
+        arg.kind     = valueKind(parser);
         arg.helpTxt  = helpStr;
         arg.optional = optional;
         arg.named    = named;
+        arg.lazy     = lazy;
+        arg.list     = list;
 
-        orderedArgs.push_back(arg);
-        usedArgNames.insert(argName);
+        sch->orderedArgs.push_back(arg);
+        sch->plan.append(argVar, parser, arg.kind, (uint8_t)(
+            (named    ? ParsePlan::PLAN_NAMED    : 0) | (optional ? ParsePlan::PLAN_OPTIONAL : 0) |
+            (lazy     ? ParsePlan::PLAN_LAZY     : 0) | (list     ? ParsePlan::PLAN_LIST     : 0)));
+        if(lazy){
+            sch->lazyArgs.push_back(sch->orderedArgs.size() - 1);
+        }
+        sch->argNames.insert(argName, (int)sch->orderedArgs.size() - 1);
+        if(named){
+            sch->nameTrie.insert(argName, (int)sch->orderedArgs.size() - 1);
+        }
+        const uint8_t nameClass = classifyArgToken(argName);
+        sch->nameClasses   |= nameClass;
+        sch->allNamesDashed = sch->allNamesDashed && (nameClass & ARG_TOKEN_DASHED) != 0;
         return true;
     }
 }
 
 CommandLineParser::CommandLineParser(const std::string& binaryName,
-    const std::string& helpMessage) : appName(binaryName),
-    helpMsg(trimWhitespaceFront(trimWhitespaceBack(helpMessage)))
+    const std::string& helpMessage) : frozen(false), stats(NULL)
 {
-    initParserTable();
+    std::shared_ptr<Schema> sch = std::make_shared<Schema>();
+    sch->appName          = binaryName;
+    sch->helpMsg          = trimWhitespaceFront(trimWhitespaceBack(helpMessage));
+    sch->responseFileMode = RESPONSE_FILES_OFF;
+    sch->allowAbbreviations = false;
+    sch->subcommandVar      = NULL;
+    sch->nameClasses        = 0;
+    sch->allNamesDashed     = true;
+    sch->hasShortFlags      = false;
+    std::fill(sch->shortFlags, sch->shortFlags + 256, (int16_t)-1);
+    schema = sch;
 }
 
-CommandLineParser::~CommandLineParser(){
-    for(int i = 0; i < 6; i++){
-        delete parsers[i]; parsers[i] = NULL;
-    }
-}
+CommandLineParser::~CommandLineParser(){}
+
+CommandLineParser::CommandLineParser(const CommandLineParser& other) :
+    schema(other.schema), frozen(other.frozen), stats(other.stats) {}
 
+CommandLineParser::CommandLineParser(CommandLineParser&& other) :
+    schema(std::move(other.schema)), frozen(other.frozen), stats(other.stats) {}
 
 CommandLineParser& CommandLineParser::operator=(const CommandLineParser& rhs){
-    helpMsg = rhs.helpMsg;
-    appName = rhs.appName;
-    usedArgNames = rhs.usedArgNames;
-    orderedArgs = rhs.orderedArgs;
-    initParserTable();
+    schema = rhs.schema;
+    frozen = rhs.frozen;
+    stats  = rhs.stats;
     return *this;
 }
 
-CommandLineParser::CommandLineParser(const CommandLineParser& other) :
-    appName(other.appName), helpMsg(other.helpMsg),
-    usedArgNames(other.usedArgNames),
-    orderedArgs(other.orderedArgs)
-{
-    initParserTable();
+CommandLineParser& CommandLineParser::operator=(CommandLineParser&& rhs){
+    schema = std::move(rhs.schema);
+    frozen = rhs.frozen;
+    stats  = rhs.stats;
+    return *this;
+}
+
+
+bool CommandLineParser::appendFlagArgument(uint64_t* flags, size_t bit,
+    const std::string& longName, char shortName, const std::string helpStr){
+
+    //The negated form keeps the dashes in front: "--verbose" becomes "--no-verbose"
+    const size_t numDashes = std::min(longName.find_first_not_of('-'), longName.size());
+    const std::string negatedName = longName.substr(0, numDashes) + "no-" +
+        longName.substr(numDashes);
+    const std::string shortStr = shortName != '\0' ? std::string("-") + shortName : std::string();
+    const bool namesOK =
+        (! longName.empty() || ! shortStr.empty())                                           &&
+        (longName.empty() || (numDashes > 0 && numDashes < longName.size() &&
+            isArgumentNameOK(longName) && isArgumentNameOK(negatedName)))                   &&
+        (shortStr.empty() || (shortName != '-' && isArgumentNameOK(shortStr)))              &&
+        longName != shortStr && schema->flags.size() < INT16_MAX;
+    Schema* sch = namesOK ? mutableSchema() : NULL;
+    if(sch == NULL){
+        return false;
+    }
+    const int idx = (int)sch->flags.size();
+    Schema::Flag flag;
+    flag.word      = flags + bit / 64;
+    flag.mask      = (uint64_t)1 << (bit % 64);
+    flag.bit       = bit;
+    flag.longName  = longName;
+    flag.shortName = shortName;
+    flag.helpTxt   = helpStr;
+    sch->flags.push_back(flag);
+    if(! longName.empty()){
+        sch->flagNames.insert(longName, 2 * idx);
+        sch->flagNames.insert(negatedName, 2 * idx + 1);
+    }
+    if(! shortStr.empty()){
+        sch->flagNames.insert(shortStr, 2 * idx);
+        sch->shortFlags[(uint8_t)shortName] = (int16_t)idx;
+        sch->hasShortFlags = true;
+    }
+    return true;
 }
 
+bool CommandLineParser::consumeFlagToken(std::string_view tok, uint8_t tokenClass,
+    bool validateOnly)const{
+    const Schema& sch = *schema;
+    if((tokenClass & ARG_TOKEN_DASHED) == 0){
+        return false;
+    }
+    const int entry = sch.flagNames.find(tok);
+    if(entry >= 0){
+        if(! validateOnly){
+            const Schema::Flag& flag = sch.flags[entry >> 1];
+            if(entry & 1){
+                *flag.word &= ~flag.mask;
+            }else{
+                *flag.word |= flag.mask;
+            }
+        }
+        return true;
+    }
+
+    //A cluster of short flags, one table lookup per character.  An argument with the same
+    //name wins.
+    if(! sch.hasShortFlags || tok.size() < 3 || tok[1] == '-'){
+        return false;
+    }
+    for(size_t i = 1; i < tok.size(); i++){
+        if(sch.shortFlags[(uint8_t)tok[i]] < 0){
+            return false;
+        }
+    }
+    if(sch.argNames.contains(tok)){
+        return false;
+    }
+    if(! validateOnly){
+        for(size_t i = 1; i < tok.size(); i++){
+            const Schema::Flag& flag = sch.flags[sch.shortFlags[(uint8_t)tok[i]]];
+            *flag.word |= flag.mask;
+        }
+    }
+    return true;
+}
 
 bool CommandLineParser::isArgumentNameOK(const std::string& name)const{
     return
         //Arg name can't be reserved for one of the "--help" keywords,
         //unless we have no help message.
-        ((!hasHelpMesage()) || (!isHelpStr(name)))            &&
+        ((!schema->hasHelpMesage()) || (!isHelpStr(name)))    &&
         //Can't use a argument name more than once.
-        (usedArgNames.find(name) == usedArgNames.end())       &&
+        (! schema->argNames.contains(name))                   &&
+        //or the name of a subcommand or a flag, or the snapshot option
+        (! schema->subcommandNames.contains(name))            &&
+        (! schema->flagNames.contains(name))                  &&
+        (name != schema->snapshotOption)                      &&
         //Argument name string can only have valid characters.
-        isValidArgString(name);
+        isValidArgName(name);
+}
+
+void CommandLineParser::setResponseFileMode(ResponseFileMode mode){
+    Schema* sch = mutableSchema();
+    if(sch != NULL){
+        sch->responseFileMode = mode;
+    }
+}
+
+void CommandLineParser::setAbbreviationsAllowed(bool allowed){
+    Schema* sch = mutableSchema();
+    if(sch != NULL){
+        sch->allowAbbreviations = allowed;
+    }
+}
+
+int CommandLineParser::lookupName(std::string_view tok, int* ambiguous)const{
+    const Schema& sch = *schema;
+    const int idx = sch.argNames.find(tok);
+    if(idx >= 0 || ! sch.allowAbbreviations || tok.empty() || tok[0] != '-' ||
+        tok.find_first_not_of('-') == std::string_view::npos){
+        return idx;
+    }
+    //Two candidates are enough to know it's ambiguous; the full list is only for the error
+    int found[2];
+    const size_t numFound = sch.nameTrie.findPrefix(tok, found, 2);
+    if(numFound == 1){
+        return found[0];
+    }
+    if(numFound > 1 && ambiguous != NULL){
+        *ambiguous = found[0];
+    }
+    return -1;
+}
+
+void CommandLineParser::setEnvironmentPrefix(const std::string& prefix){
+    Schema* sch = mutableSchema();
+    if(sch != NULL){
+        sch->envPrefix = prefix;
+    }
+}
+
+void CommandLineParser::setConfigFile(const std::string& path, const std::string& cachePath){
+    Schema* sch = mutableSchema();
+    if(sch != NULL){
+        sch->configPath      = path;
+        sch->configCachePath = cachePath;
+    }
+}
+
+std::string CommandLineParser::environmentVariableName(const std::string& argName)const{
+    if(schema->envPrefix.empty()){
+        return "";
+    }
+    std::string ret = schema->envPrefix + "_";
+    size_t i = 0;
+    while(i < argName.size() && argName[i] == '-'){
+        ++i;
+    }
+    for(; i < argName.size(); i++){
+        const char c = argName[i];
+        ret += c == '-' ? '_' : (char)toupper((unsigned char)c);
+    }
+    return ret;
+}
+
+ArgValueKind CommandLineParser::valueKind(const ArgParser* parser){
+    if(parser == getCommonArgParser(AP_INT)){
+        return ARG_KIND_INT;
+    }else if(parser == getCommonArgParser(AP_UINT)){
+        return ARG_KIND_UINT;
+    }else if(parser == getCommonArgParser(AP_FLOAT)){
+        return ARG_KIND_FLOAT;
+    }else if(parser == getCommonArgParser(AP_DOUBLE)){
+        return ARG_KIND_DOUBLE;
+    }else if(parser == getCommonArgParser(AP_STRING)){
+        return ARG_KIND_STRING;
+    }else if(parser == getCommonArgParser(AP_BOOLEAN)){
+        return ARG_KIND_BOOL;
+    }
+    return ARG_KIND_CUSTOM;
+}
+
+uint64_t CommandLineParser::schemaFingerprint()const{
+    std::string desc;
+    for(size_t i = 0; i < schema->orderedArgs.size(); i++){
+        const struct Arg& arg = schema->orderedArgs[i];
+        desc += arg.name;
+        desc += '\0';
+        desc += (char)arg.kind;
+        desc += (char)((arg.named ? 1 : 0) | (arg.optional ? 2 : 0) | (arg.lazy ? 4 : 0) | (arg.list ? 8 : 0));
+    }
+    //Flags and verbs each start with a byte no name contains, so they can't pass for arguments
+    for(size_t i = 0; i < schema->flags.size(); i++){
+        const Schema::Flag& flag = schema->flags[i];
+        desc += '\1';
+        desc += flag.longName;
+        desc += '\0';
+        desc += flag.shortName;
+        desc.append((const char*)&flag.bit, sizeof(flag.bit));
+    }
+    for(size_t i = 0; i < schema->subcommands.size(); i++){
+        desc += '\2';
+        desc += schema->subcommands[i]->verb;
+    }
+    return ArgNameTable::hash(desc);
 }
 
 bool CommandLineParser::appendPositionalArgument(void* argVar, const std::string argName,
@@ -175,223 +475,1253 @@ bool CommandLineParser::appendNamedArgument(void* argVar, const std::string argN
     return appendArgHelper(argVar, argName, parser, helpStr, optional, true);
 }
 
+bool CommandLineParser::appendLazyNamedArgument(LazyArgBase* handle, const std::string argName,
+    bool optional, const std::string helpStr){
+    return appendArgHelper(handle, argName, handle->getParser(), helpStr, optional, true, true);
+}
+
+bool CommandLineParser::materializeLazyArguments(std::list<std::string>& errs)const{
+    bool noErr = true;
+    for(size_t i = 0; i < schema->lazyArgs.size(); i++){
+        const LazyArgBase* handle = (const LazyArgBase*)schema->orderedArgs[schema->lazyArgs[i]].var;
+        std::string errStr;
+        if(! handle->materialize(errStr)){
+            errs.push_back(errStr);
+            noErr = false;
+        }
+    }
+    return noErr;
+}
+
+bool CommandLineParser::appendSubcommand(const std::string& verb, SubcommandFactory* factory,
+    const std::string helpStr){
+    if(frozen || factory == NULL || ! isArgumentNameOK(verb)){
+        return false;
+    }
+    Schema* sch = mutableSchema();
+    std::shared_ptr<Schema::Subcommand> sub = std::make_shared<Schema::Subcommand>();
+    sub->verb    = verb;
+    sub->helpTxt = helpStr;
+    sub->factory = factory;
+    sub->built   = false;
+    sch->subcommandNames.insert(verb, (int)sch->subcommands.size());
+    sch->subcommands.push_back(sub);
+    return true;
+}
+
+void CommandLineParser::setSubcommandVariable(std::string* verb){
+    Schema* sch = mutableSchema();
+    if(sch != NULL){
+        sch->subcommandVar = verb;
+    }
+}
+
+bool CommandLineParser::addDependency(const std::string& argName,
+    const std::string& requiredName){
+    const int idx   = schema->argNames.find(argName);
+    const int other = schema->argNames.find(requiredName);
+    Schema* sch = idx >= 0 && other >= 0 && idx != other ? mutableSchema() : NULL;
+    if(sch == NULL){
+        return false;
+    }
+    sch->rules.addDependency((size_t)idx, (size_t)other);
+    return true;
+}
+
+bool CommandLineParser::addExclusion(const std::string& argName, const std::string& otherName){
+    const int idx   = schema->argNames.find(argName);
+    const int other = schema->argNames.find(otherName);
+    Schema* sch = idx >= 0 && other >= 0 && idx != other ? mutableSchema() : NULL;
+    if(sch == NULL){
+        return false;
+    }
+    sch->rules.addExclusion((size_t)idx, (size_t)other);
+    return true;
+}
+
+bool CommandLineParser::setRange(const std::string& argName, double minValue, double maxValue){
+    const int idx = schema->argNames.find(argName);
+    if(idx < 0 || !(minValue <= maxValue)){
+        return false;
+    }
+    const struct Arg& arg = schema->orderedArgs[idx];
+    const bool numeric = arg.kind == ARG_KIND_INT || arg.kind == ARG_KIND_UINT ||
+        arg.kind == ARG_KIND_FLOAT || arg.kind == ARG_KIND_DOUBLE;
+    Schema* sch = numeric && ! arg.lazy && ! arg.list ? mutableSchema() : NULL;
+    if(sch == NULL){
+        return false;
+    }
+    sch->plan.setRange((size_t)idx, minValue, maxValue);
+    return true;
+}
+
+std::string CommandLineParser::rangeMessage(size_t idx, const std::string& tok)const{
+    const ParsePlan& plan = schema->plan;
+    return "Value " + tok + " of argument " + schema->orderedArgs[idx].name +
+        " is out of range [" + formatRangeBound(plan.rangeMin(idx)) + ", " +
+        formatRangeBound(plan.rangeMax(idx)) + "].";
+}
+
+const CommandLineParser& CommandLineParser::subcommandParser(size_t i)const{
+    Schema::Subcommand& sub = *schema->subcommands[i];
+    std::call_once(sub.buildOnce, [&](){
+        std::shared_ptr<CommandLineParser> parser =
+            std::make_shared<CommandLineParser>(schema->appName + " " + sub.verb, sub.helpTxt);
+        sub.factory->buildParser(*parser);
+        parser->freeze();
+        sub.parser = parser;
+        sub.built  = true;
+    });
+    return *sub.parser;
+}
+
+void CommandLineParser::resetLazyArguments()const{
+    const Schema& sch = *schema;
+    for(size_t i = 0; i < sch.lazyArgs.size(); i++){
+        ((LazyArgBase*)sch.orderedArgs[sch.lazyArgs[i]].var)->reset();
+    }
+}
+
+void CommandLineParser::pinLazyTokens()const{
+    const Schema& sch = *schema;
+    for(size_t i = 0; i < sch.lazyArgs.size(); i++){
+        ((LazyArgBase*)sch.orderedArgs[sch.lazyArgs[i]].var)->pinToken();
+    }
+    for(size_t i = 0; i < sch.subcommands.size(); i++){
+        if(sch.subcommands[i]->built){
+            sch.subcommands[i]->parser->pinLazyTokens();
+        }
+    }
+}
+
 CommandLineParser::ParseDoneStatus CommandLineParser::parse(int argc,
     char** argv, std::list<std::string>& errs, std::ostream& os)const{
 
-    //Make a list of arguments
-    std::list<std::string> args;
-    for(int i = 1; i < argc; i++){ //This is 1(not 0) to skip the program name
-        args.push_back(std::string(argv[i]));
+    //Small parses fit entirely in this stack buffer; bigger ones spill to the heap
+    char scratch[4096];
+    std::pmr::monotonic_buffer_resource arena(scratch, sizeof(scratch));
+    ParseErrors errors(8, &arena);
+    const ParseDoneStatus status = parseWithResource(argc, argv, errors, os, &arena, true);
+    errors.appendMessages(errs);
+    return status;
+}
+
+CommandLineParser::ParseDoneStatus CommandLineParser::parse(int argc, char** argv,
+    std::list<std::string>& errs, std::pmr::memory_resource* resource, std::ostream& os)const{
+    ParseErrors errors(8, resource);
+    const ParseDoneStatus status = parseWithResource(argc, argv, errors, os, resource, false);
+    errors.appendMessages(errs);
+    return status;
+}
+
+CommandLineParser::ParseDoneStatus CommandLineParser::parse(int argc,
+    char** argv, ParseErrors& errors, std::ostream& os)const{
+    char scratch[4096];
+    std::pmr::monotonic_buffer_resource arena(scratch, sizeof(scratch));
+    return parseWithResource(argc, argv, errors, os, &arena, true);
+}
+
+CommandLineParser::ParseDoneStatus CommandLineParser::parse(int argc, char** argv,
+    ParseErrors& errors, std::pmr::memory_resource* resource, std::ostream& os)const{
+    return parseWithResource(argc, argv, errors, os, resource, false);
+}
+
+CommandLineParser::ParseDoneStatus CommandLineParser::parseStreaming(int argc, char** argv,
+    std::list<std::string>& errs, int fd, ArgStreamSink& sink, ArgStreamReader::Delimiter delim,
+    std::ostream& os)const{
+
+    const ParseDoneStatus status = parse(argc, argv, errs, os);
+    if(status != SUCCESS){
+        return status;
+    }
+    ArgStreamReader reader(fd, delim);
+    std::string errStr;
+    if(! reader.run(sink, errStr)){
+        errs.push_back("Streamed argument " + std::to_string(reader.count()) + ": " + errStr);
+        return ERROR;
     }
+    return SUCCESS;
+}
 
-    //First check if we should print the help message and be done
-    for(std::list<std::string>::iterator itr = args.begin(); itr != args.end(); itr++){
-        if(isHelpStr(*itr)){
-            printHelpMessage(appName);
-            return HELP_PRINTED;
+CommandLineParser::ParseDoneStatus CommandLineParser::writeSnapshot(int argc, char** argv,
+    std::string& snapshot, std::list<std::string>& errs, std::ostream& os)const{
+
+    snapshot.clear();
+    char scratch[4096];
+    std::pmr::monotonic_buffer_resource arena(scratch, sizeof(scratch));
+    ParseErrors errors(8, &arena);
+    ParseSnapshot record(schemaFingerprint());
+    const ParseDoneStatus status = parseWithResource(argc, argv, errors, os, &arena, true, &record);
+    errors.appendMessages(errs);
+    if(status == SUCCESS){
+        snapshot = record.bytes();
+    }
+    return status;
+}
+
+bool CommandLineParser::loadSnapshot(const std::string& source, std::string& err)const{
+    const bool isFd = ! source.empty() &&
+        source.find_first_not_of("0123456789") == std::string::npos;
+    ResponseFile file;
+    std::string errStr;
+    if(! file.open(isFd ? "/dev/fd/" + source : source, errStr)){
+        err = "Could not read the snapshot " + source;
+        return false;
+    }
+    uint64_t fingerprint = 0;
+    std::string_view records;
+    if(! ParseSnapshot::readHeader(file.contents(), fingerprint, records)){
+        err = "Not a parse snapshot: " + source;
+        return false;
+    }
+    if(fingerprint != schemaFingerprint()){
+        err = "The snapshot " + source + " was made for a different argument list.";
+        return false;
+    }
+    if(! applySnapshot(records, false, err)){
+        err = "Snapshot " + source + ": " + err;
+        return false;
+    }
+    return applySnapshot(records, true, err);
+}
+
+bool CommandLineParser::setSnapshotOption(const std::string& optionName){
+    Schema* sch = isArgumentNameOK(optionName) ? mutableSchema() : NULL;
+    if(sch == NULL){
+        return false;
+    }
+    sch->snapshotOption = optionName;
+    return true;
+}
+
+void CommandLineParser::recordArg(ParseSnapshot& record, size_t idx,
+    const std::string_view* begin, const std::string_view* end)const{
+    const ParsePlan& plan = schema->plan;
+    if(plan.kind(idx) != ARG_KIND_CUSTOM && ! plan.lazy(idx) && ! plan.list(idx)){
+        record.addValue(idx, plan.kind(idx), plan.var(idx));
+    }else{
+        record.addTokens(idx, begin, end);
+    }
+}
+
+bool CommandLineParser::applySnapshot(std::string_view records, bool apply,
+    std::string& err)const{
+
+    //The records after a verb belong to the verb's parser
+    const CommandLineParser* parser = this;
+    if(apply){
+        resetLazyArguments();
+    }
+    std::vector<std::string_view> tokens;
+    ParseSnapshot::Record rec;
+    while(ParseSnapshot::nextRecord(records, rec)){
+        const Schema& sch = *parser->schema;
+        const ParsePlan& plan = sch.plan;
+        if(rec.kind == ParseSnapshot::RECORD_FLAG){
+            if(! parser->consumeFlagToken(rec.payload, classifyArgToken(rec.payload), ! apply)){
+                err = "Unknown flag " + std::string(rec.payload);
+                return false;
+            }
+            continue;
+        }
+        if(rec.kind == ParseSnapshot::RECORD_SUBCOMMAND){
+            if(rec.index >= sch.subcommands.size() || parser->subcommandParser(rec.index).
+                schemaFingerprint() != ParseSnapshot::subcommandFingerprint(rec.payload)){
+                err = "The argument list of a command changed.";
+                return false;
+            }
+            if(apply && sch.subcommandVar != NULL){
+                *sch.subcommandVar = sch.subcommands[rec.index]->verb;
+            }
+            parser = &parser->subcommandParser(rec.index);
+            if(apply){
+                parser->resetLazyArguments();
+            }
+            continue;
+        }
+
+        const size_t idx = rec.index;
+        if(idx >= plan.size()){
+            err = "Argument " + std::to_string(idx) + " does not exist.";
+            return false;
+        }
+        const bool hasBinaryForm = plan.kind(idx) != ARG_KIND_CUSTOM && ! plan.lazy(idx) &&
+            ! plan.list(idx);
+        if((rec.kind == ParseSnapshot::RECORD_VALUE) != hasBinaryForm){
+            err = "Argument " + sch.orderedArgs[idx].name + " is stored in the wrong form.";
+            return false;
+        }
+        if(hasBinaryForm){
+            //Strings need no check, and the numeric kinds fit in the scratch space
+            NumericArgValue value;
+            if(plan.kind(idx) != ARG_KIND_STRING && (! decodeArgValue(plan.kind(idx), rec.payload,
+                &value) || (plan.hasRange(idx) && ! inArgRange(plan, idx, &value)))){
+                err = "Bad value for argument " + sch.orderedArgs[idx].name;
+                return false;
+            }
+            if(apply){
+                decodeArgValue(plan.kind(idx), rec.payload, plan.var(idx));
+            }
+            continue;
+        }
+
+        tokens.clear();
+        std::string_view payload = rec.payload, tok;
+        while(ParseSnapshot::nextToken(payload, tok)){
+            tokens.push_back(tok);
+        }
+        if(! payload.empty() || (plan.lazy(idx) && tokens.size() != 1)){
+            err = "Bad tokens for argument " + sch.orderedArgs[idx].name;
+            return false;
+        }
+        if(plan.lazy(idx)){
+            if(apply){
+                //The snapshot is unmapped once it is loaded
+                LazyArgBase* handle = (LazyArgBase*)plan.var(idx);
+                handle->record(tokens[0]);
+                handle->pinToken();
+            }
+            continue;
+        }
+        ArgCursor cursor(tokens.data(), tokens.data() + tokens.size());
+        void* var = plan.var(idx);
+        const bool success = apply ? plan.parser(idx)->parseArg(cursor, var, err) :
+            plan.parser(idx)->validateArg(cursor, var, err);
+        if(! success || ! cursor.empty()){
+            if(err.empty()){
+                err = "Bad tokens for argument " + sch.orderedArgs[idx].name;
+            }
+            return false;
         }
     }
+    if(! records.empty()){
+        err = "The snapshot is cut short.";
+        return false;
+    }
+    return true;
+}
 
-    //Make a mutable list of the ordered arguments
-    std::list<struct Arg> mArgList;
-    for(size_t i = 0; i < orderedArgs.size(); i++){
-        mArgList.push_back(orderedArgs[i]);
+CommandLineParser::ParseDoneStatus CommandLineParser::parseWithResource(int argc, char** argv,
+    ParseErrors& errors, std::ostream& os, std::pmr::memory_resource* resource,
+    bool allowThreads, ParseSnapshot* record)const{
+
+    const Schema& sch = *schema;
+    errors.setSource(this);
+    if(argc >= 2 && argv[1][0] == '-' && argv[1][1] == '-' && argv[1][2] == '_' &&
+        handleCompletionRequest(argc, argv, os)){
+        return HELP_PRINTED;
+    }
+    int firstArg = 1; //This is 1(not 0) to skip the program name
+    if(argc >= 3 && ! sch.snapshotOption.empty() && sch.snapshotOption == argv[1]){
+        std::string errStr;
+        if(loadSnapshot(argv[2], errStr)){
+            return SUCCESS;
+        }
+        firstArg = 3; //Parse the command line that follows the snapshot instead
+    }
+#ifdef CMD_PARSE_STATS
+    ParseStats* st = stats;
+    ParseStats::CountingResource countingResource(resource, st);
+    if(st != NULL){
+        if(st->args.size() != sch.orderedArgs.size()){
+            st->args.resize(sch.orderedArgs.size());
+            st->clear();
+        }
+        for(size_t i = 0; i < sch.orderedArgs.size(); i++){
+            if(st->args[i].name != sch.orderedArgs[i].name){
+                st->args[i].name = sch.orderedArgs[i].name;
+            }
+        }
+        ++st->parses;
+        resource = &countingResource;
+    }
+#endif
+    //Response files are mapped for the duration of the parse, and their entries are
+    //spliced into the token list in place of the "@path" argument
+    std::pmr::list<ResponseFile> responseFiles(resource);
+    try{
+        //Make a list of views onto argv.  No argument text is copied.
+        PARSE_STATS_PHASE(argvPhase, st, PHASE_ARGV_COPY);
+        std::pmr::vector<std::string_view> tokens(resource);
+        tokens.reserve(argc > firstArg ? (size_t)(argc - firstArg) : 0);
+        for(int i = firstArg; i < argc; i++){
+            const std::string_view tok(argv[i]);
+            if(sch.responseFileMode != RESPONSE_FILES_OFF && tok.size() > 1 && tok[0] == '@'){
+                std::string errStr;
+                responseFiles.emplace_back(resource);
+                if(! responseFiles.back().open(tok.substr(1), errStr)){
+                    errors.add(PARSE_ERR_RESPONSE_FILE, -1, (int)tokens.size(), tok, errStr);
+                    return ERROR;
+                }
+                responseFiles.back().tokenize(tokens, sch.responseFileMode == RESPONSE_FILES_SHELL_QUOTED,
+                    allowThreads ? 0 : 1);
+            }else{
+                tokens.push_back(tok);
+            }
+        }
+        PARSE_STATS_END(argvPhase);
+
+        //Forget what the lazy arguments recorded in the previous parse
+        resetLazyArguments();
+
+        ArgCursor args(tokens.data(), tokens.data() + tokens.size());
+        const ParseDoneStatus status = parseTokens(args, errors, &os, false, resource, record);
+
+        //Tokens from response files go away with the files, so lazy arguments and errors
+        //keep a copy
+        if(! responseFiles.empty()){
+            pinLazyTokens();
+            errors.pinTokens();
+        }
+        return status;
+    }catch(const std::bad_alloc&){
+        if(! responseFiles.empty()){
+            errors.pinTokens();
+        }
+        errors.add(PARSE_ERR_OUT_OF_MEMORY, -1, -1, std::string_view());
+        return ERROR;
+    }
+}
+
+struct CommandLineParser::LoadedConfig{
+    ConfigFile file;
+    bool ok;
+    std::string err; //Why the file could not be loaded, if ! ok
+
+    LoadedConfig() : ok(false) {}
+};
+
+struct CommandLineParser::FallbackState{
+    const LoadedConfig* config; //NULL until some argument needs the config file
+    LoadedConfig ownConfig;     //What config points to, unless parseBatch shared its copy
+    std::string_view usedText;  //The text of the last fallback used, for snapshots
+
+    explicit FallbackState(const LoadedConfig* config) : config(config) {}
+};
+
+void CommandLineParser::parseBatch(const std::vector<std::vector<std::string> >& cmdLines,
+    std::vector<BatchResult>& results, std::vector<std::string>& errors, unsigned numThreads)const{
+
+    ParseErrors records;
+    parseBatch(cmdLines, results, records, numThreads);
+    errors.resize(records.size());
+    for(size_t i = 0; i < records.size(); i++){
+        errors[i] = records.message(i);
+    }
+}
+
+void CommandLineParser::parseBatch(const std::vector<std::vector<std::string> >& cmdLines,
+    std::vector<BatchResult>& results, ParseErrors& errors, unsigned numThreads)const{
+
+    results.assign(cmdLines.size(), BatchResult());
+    errors.clear();
+    errors.setSource(this);
+    if(cmdLines.empty()){
+        return;
+    }
+
+    if(numThreads == 0){
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    //Lines are handed out in chunks so that workers don't fight over the counter
+    const size_t CHUNK_SIZE = 64;
+    const size_t numChunks = (cmdLines.size() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    numThreads = (unsigned)std::min<size_t>(numThreads, numChunks);
+
+    //Load the config file up front, so that the workers share one read only copy instead of
+    //every line loading it again
+    LoadedConfig config;
+    if(! schema->configPath.empty()){
+        loadConfig(config);
+    }
+
+    //Each worker keeps its own scratch token buffer and error records, and only writes to
+    //the entries of "results" for the lines it parsed
+    std::vector<ParseErrors> workerErrs(numThreads);
+    std::atomic<size_t> nextChunk(0);
+    auto worker = [&](unsigned workerIdx){
+        std::pmr::vector<std::string_view> tokens(std::pmr::new_delete_resource());
+        ParseErrors& myErrs = workerErrs[workerIdx];
+        myErrs.setSource(this); //Records name arguments through the parser that made them
+        for(size_t chunk = nextChunk++; chunk < numChunks; chunk = nextChunk++){
+            const size_t end = std::min(cmdLines.size(), (chunk + 1) * CHUNK_SIZE);
+            for(size_t line = chunk * CHUNK_SIZE; line < end; line++){
+                const std::vector<std::string>& argv = cmdLines[line];
+                tokens.clear();
+                for(size_t i = 1; i < argv.size(); i++){ //Skip the program name
+                    tokens.push_back(argv[i]);
+                }
+                ArgCursor args(tokens.data(), tokens.data() + tokens.size());
+
+                BatchResult& res = results[line];
+                res.firstError  = myErrs.size();
+                res.status      = parseTokens(args, myErrs, NULL, true, std::pmr::new_delete_resource(),
+                    NULL, schema->configPath.empty() ? NULL : &config);
+                res.worker      = workerIdx;
+                res.numErrors   = myErrs.size() - res.firstError;
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for(unsigned i = 1; i < numThreads; i++){
+        pool.push_back(std::thread(worker, i));
+    }
+    worker(0);
+    for(size_t i = 0; i < pool.size(); i++){
+        pool[i].join();
+    }
+
+    //Concatenate the per-worker records into "errors" and point each result at its range
+    std::vector<size_t> workerOffset(numThreads, 0);
+    for(unsigned i = 0; i < numThreads; i++){
+        workerOffset[i] = errors.size();
+        errors.append(workerErrs[i]);
+    }
+    for(size_t line = 0; line < results.size(); line++){
+        results[line].firstError += workerOffset[results[line].worker];
+    }
+}
+
+void CommandLineParser::loadConfig(LoadedConfig& config)const{
+    const Schema& sch = *schema;
+    std::vector<ConfigFile::Key> keys(sch.orderedArgs.size());
+    for(size_t i = 0; i < keys.size(); i++){
+        keys[i].name = sch.orderedArgs[i].name;
+        //Lazy and list arguments go through their ArgParser, so they keep their text
+        const struct Arg& key = sch.orderedArgs[i];
+        keys[i].kind = key.lazy || key.list ? ARG_KIND_CUSTOM : key.kind;
+    }
+    config.err.clear();
+    config.ok = config.file.load(sch.configPath, sch.configCachePath, keys.data(), keys.size(),
+        schemaFingerprint(), config.err);
+}
+
+bool CommandLineParser::applyFallbackText(size_t idx, std::string_view text,
+    std::string& err, bool validateOnly)const{
+    const struct Arg& arg = schema->orderedArgs[idx];
+    ArgCursor cursor(&text, &text + 1);
+    if(arg.lazy && ! validateOnly){
+        LazyArgBase* handle = (LazyArgBase*)arg.var;
+        handle->record(text);
+        handle->pinToken(); //The environment and the config file may change later
+        return true;
+    }
+    if(arg.lazy || arg.list){
+        void* var = arg.lazy ? ((LazyArgBase*)arg.var)->valueStorage() : arg.var;
+        return validateOnly ? arg.parser->validateArg(cursor, var, err) :
+            arg.parser->parseArg(cursor, var, err);
+    }
+    bool outOfRange = false;
+    if(convertArg(idx, arg.var, cursor, err, validateOnly, outOfRange)){
+        return true;
+    }
+    if(outOfRange){
+        err = rangeMessage(idx, std::string(text));
+    }else if(err.empty()){
+        err = "Parse error on argument: \"" + std::string(text) + "\"";
+    }
+    return false;
+}
+
+CommandLineParser::FallbackResult CommandLineParser::applyFallback(size_t idx,
+    FallbackState& state, ParseErrors& errors, bool validateOnly)const{
+
+    const Schema& sch = *schema;
+    const struct Arg& arg = sch.orderedArgs[idx];
+    std::string errStr;
+
+    if(! sch.envPrefix.empty()){
+        const std::string envName = environmentVariableName(arg.name);
+        const char* envValue = getenv(envName.c_str());
+        if(envValue != NULL){
+            if(! applyFallbackText(idx, envValue, errStr, validateOnly)){
+                errStr = "Environment variable " + envName + ": " + errStr;
+                errors.add(PARSE_ERR_FALLBACK, (int)idx, -1, std::string_view(), errStr);
+                return FALLBACK_ERROR;
+            }
+            state.usedText = envValue;
+            return FALLBACK_USED;
+        }
+    }
+
+    if(! sch.configPath.empty()){
+        if(state.config == NULL){
+            loadConfig(state.ownConfig);
+            state.config = &state.ownConfig;
+        }
+        if(! state.config->ok){
+            errors.add(PARSE_ERR_FALLBACK, (int)idx, -1, std::string_view(), state.config->err);
+            return FALLBACK_ERROR;
+        }
+        const ConfigFile& config = state.config->file;
+        if(config.has(idx)){
+            if(arg.kind != ARG_KIND_CUSTOM && ! arg.lazy && ! arg.list){
+                //Already converted when the config was read
+                if(sch.plan.hasRange(idx)){
+                    NumericArgValue value;
+                    decodeArgValue(arg.kind, config.value(idx), &value);
+                    if(! inArgRange(sch.plan, idx, &value)){
+                        errStr = "Config file " + sch.configPath + ": " +
+                            rangeMessage(idx, formatRangeBound(numericArgValue(arg.kind, &value)));
+                        errors.add(PARSE_ERR_FALLBACK, (int)idx, -1, std::string_view(), errStr);
+                        return FALLBACK_ERROR;
+                    }
+                }
+                if(! validateOnly){
+                    decodeArgValue(arg.kind, config.value(idx), arg.var);
+                }
+            }else if(! applyFallbackText(idx, config.value(idx), errStr, validateOnly)){
+                errStr = "Config file " + sch.configPath + ": " + errStr;
+                errors.add(PARSE_ERR_FALLBACK, (int)idx, -1, std::string_view(), errStr);
+                return FALLBACK_ERROR;
+            }
+            state.usedText = config.value(idx);
+            return FALLBACK_USED;
+        }
+    }
+    return FALLBACK_NONE;
+}
+
+inline bool CommandLineParser::convertArg(size_t idx, void* var, ArgCursor& args,
+    std::string& err, bool validateOnly, bool& outOfRange)const{
+    const ParsePlan& plan = schema->plan;
+    const ArgValueKind kind = plan.kind(idx);
+    if(plan.hasRange(idx)){
+        //Convert into scratch space so that a value out of range is never stored
+        NumericArgValue value;
+        if(! convertCommonArg(kind, args, &value, err)){
+            return false;
+        }
+        if(! inArgRange(plan, idx, &value)){
+            outOfRange = true;
+            return false;
+        }
+        if(! validateOnly){
+            storeNumericArgValue(kind, &value, var);
+        }
+        return true;
+    }
+    if(kind != ARG_KIND_CUSTOM){
+        return convertCommonArg(kind, args, validateOnly ? NULL : var, err);
+    }
+    return validateOnly ? plan.parser(idx)->validateArg(args, var, err) :
+        plan.parser(idx)->parseArg(args, var, err);
+}
+
+bool CommandLineParser::parseListArg(size_t idx, ArgCursor& args,
+    const uint8_t* classes, std::string& err, bool validateOnly)const{
+    const ParsePlan& plan = schema->plan;
+    //The list is every token up to the next argument name
+    const std::string_view* stop = args.begin();
+    const bool hasFlags = ! schema->flags.empty();
+    while(stop != args.end() && lookupToken(*stop, classes[stop - args.begin()]) < 0 &&
+        !(hasFlags && consumeFlagToken(*stop, classes[stop - args.begin()], true))){
+        ++stop;
+    }
+    ArgCursor listArgs(args.begin(), stop);
+    listArgs.setWantsErrorText(args.wantsErrorText());
+    if(listArgs.empty() && ! plan.named(idx)){
+        if(args.wantsErrorText()){
+            err = "No values given for list argument " + schema->orderedArgs[idx].name;
+        }
+        return false;
+    }
+    const bool success = validateOnly ?
+        plan.parser(idx)->validateArg(listArgs, plan.var(idx), err) :
+        plan.parser(idx)->parseArg(listArgs, plan.var(idx), err);
+    while(args.begin() != listArgs.begin()){
+        args.popFront();
+    }
+    return success;
+}
+
+void CommandLineParser::addParserError(ParseErrors& errors, int argId, const std::string_view* base,
+    const std::string_view* before, const ArgCursor& args, const std::string& errStr,
+    bool outOfRange)const{
+    if(outOfRange){
+        const std::string_view* bad = args.begin() - 1;
+        errors.add(PARSE_ERR_OUT_OF_RANGE, argId, (int)(bad - base), *bad);
+    }else if(! errStr.empty()){
+        errors.add(PARSE_ERR_PARSER_MESSAGE, argId, (int)(before - base),
+            before != args.end() ? *before : std::string_view(), errStr);
+    }else if(args.begin() != before){
+        //The parser consumed the bad value last(see ArgCursor::wantsErrorText)
+        const std::string_view* bad = args.begin() - 1;
+        errors.add(PARSE_ERR_BAD_VALUE, argId, (int)(bad - base), *bad);
+    }else if(schema->plan.list(argId)){
+        errors.add(PARSE_ERR_MISSING_VALUE, argId, (int)(before - base), std::string_view());
+    }else{
+        errors.add(PARSE_ERR_PARSER_MESSAGE, argId, (int)(before - base), std::string_view());
+    }
+}
+
+CommandLineParser::ParseDoneStatus CommandLineParser::parseTokens(ArgCursor& args,
+    ParseErrors& errors, std::ostream* os, bool validateOnly,
+    std::pmr::memory_resource* resource, ParseSnapshot* record, const LoadedConfig* config)const{
+
+    const Schema& sch = *schema;
+    const ParsePlan& plan = sch.plan;
+    const std::string_view* const base = args.begin(); //classes[] and error token indices count from here
+    args.setWantsErrorText(false); //Errors are recorded, and only formatted on request
+#ifdef CMD_PARSE_STATS
+    ParseStats* st = validateOnly ? NULL : stats; //parseBatch runs this on several threads
+#endif
+
+    //Classify every token in one sweep(see ArgClassify.h).  The help check and the name
+    //lookups below work from the classes.
+    PARSE_STATS_PHASE(helpPhase, st, PHASE_HELP_SCAN);
+    const size_t numTokens = args.size();
+    uint8_t localClasses[256];
+    std::pmr::vector<uint8_t> heapClasses(resource);
+    if(numTokens > sizeof(localClasses)){
+        heapClasses.resize(numTokens);
     }
+    uint8_t* const classes = numTokens > sizeof(localClasses) ? heapClasses.data() : localClasses;
+    classifyArgTokens(base, numTokens, classes);
 
-    while(args.size() > 0){ //Keep parsing argumuments until none are left
+    //First check if we should print the help message and be done.  Help after a subcommand's
+    //verb is for the subcommand, and where the verb is is only known once our own arguments
+    //are matched(a value may be spelled like a verb).  So with subcommands, the tokens before
+    //the verb are checked when the verb is reached, and all of them when matching fails.
+    const bool hasSubcommands = ! sch.subcommands.empty();
+    auto askedForHelp = [&](size_t numOwnTokens){
+        for(size_t i = 0; i < numOwnTokens; i++){
+            if(classes[i] & ARG_TOKEN_HELP){
+                if(os != NULL){
+                    printHelpMessage(sch.appName, *os);
+                }
+                return true;
+            }
+        }
+        return false;
+    };
+    if(! hasSubcommands && askedForHelp(numTokens)){
+        PARSE_STATS_END(helpPhase);
+        return HELP_PRINTED;
+    }
+    PARSE_STATS_END(helpPhase);
+    const size_t firstError = errors.size();
+    size_t numOwnTokens = numTokens; //The tokens before the verb, once it is found
+    auto failed = [&](){ //Every error return below goes through here
+        if(hasSubcommands && askedForHelp(numOwnTokens)){
+            errors.truncate(firstError);
+            return HELP_PRINTED;
+        }
+        return ERROR;
+    };
 
-        if(mArgList.size() == 0){
+    //Per-parse record of which arguments have been consumed(one bit per entry in the plan)
+    const size_t numArgs = plan.size();
+    ArgBitset consumed(numArgs, resource);
+
+    //Arguments missing from argv may come from the environment or a config file
+    const bool useFallbacks = ! sch.envPrefix.empty() || ! sch.configPath.empty();
+    FallbackState fallback(config);
+
+    size_t nextArg = 0; //First argument of the next group in the plan to be matched
+    int subcommand = -1; //Index of the verb in sch.subcommands, once it is found
+    const bool hasFlags = ! sch.flags.empty();
+    while(! args.empty()){ //Keep parsing argumuments until none are left
+
+        //Flags may appear anywhere, so take them out before matching anything else
+        if(hasFlags && consumeFlagToken(args.front(), classes[args.begin() - base], validateOnly)){
+            if(record != NULL){
+                record->addFlag(args.front());
+            }
+            args.popFront();
+            continue;
+        }
+        if(nextArg == numArgs && hasSubcommands){
+            //Our own arguments are done; the rest belongs to the subcommand
+            subcommand = sch.subcommandNames.find(args.front());
+            if(subcommand >= 0){
+                numOwnTokens = (size_t)(args.begin() - base);
+                args.popFront();
+                break;
+            }
+        }
+        if(nextArg == numArgs){
             //This indicates that some argument(s) in args are not matched with anything
-            for(std::list<std::string>::iterator it = args.begin(); it != args.end(); it++){
-                if(usedArgNames.find(*it) != usedArgNames.end()){
-                    errs.push_back("Argument " + *it +
-                        " appeared more then once(or in an invalid manner)" +
-                        "in the argument list.");
-                }else{
-                    errs.push_back("Argument " + *it + " is not recognized.");
+            for(const std::string_view* it = args.begin(); it != args.end(); it++){
+                if(hasFlags && consumeFlagToken(*it, classes[it - base], true)){
+                    continue;
                 }
+                const int idx = lookupToken(*it, classes[it - base]);
+                errors.add(idx >= 0 ? PARSE_ERR_DUPLICATE : PARSE_ERR_UNRECOGNIZED, idx,
+                    (int)(it - base), *it);
             }
-            return ERROR;
+            return failed();
         }
 
         //Check if we are parsing a single positional argument or a sequence of optional arguments
-        struct Arg currParser = Arg(mArgList.front());
-        mArgList.pop_front();
-        if(! currParser.named){ //We are dealing with a single positional non-named argument
+        if(! plan.named(nextArg)){ //We are dealing with a single positional non-named argument
             //Parse one positional argument
-            std::string errStr = "";
-            const bool success = currParser.parser->parseArg(args, currParser.var, errStr);
+            PARSE_STATS_PHASE(positionalPhase, st, PHASE_POSITIONAL);
+            PARSE_STATS_ARG(argCost, st, nextArg);
+            std::string errStr;
+            bool outOfRange = false;
+            const std::string_view* before = args.begin();
+            const bool success = plan.list(nextArg) ?
+                parseListArg(nextArg, args, classes + (args.begin() - base), errStr, validateOnly) :
+                convertArg(nextArg, plan.var(nextArg), args, errStr, validateOnly, outOfRange);
             if(!success){
-                errs.push_back(errStr);
-                return ERROR;
+                addParserError(errors, (int)nextArg, base, before, args, errStr, outOfRange);
+                return failed();
+            }
+            if(record != NULL){
+                recordArg(*record, nextArg, before, args.begin());
             }
+            consumed.set(nextArg);
+            ++nextArg;
 
         }else{ //We are dealing with 1 or more named arguments
 
-            //Make a std::set of all the named arguments
-            std::set<struct Arg> namedArgParserList;
-            namedArgParserList.insert(currParser);
-            while(mArgList.size() > 0 && mArgList.front().named){
-                namedArgParserList.insert(Arg(mArgList.front()));
-                mArgList.pop_front();
-            }
+            //The run [groupBegin, groupEnd) of adjacent named arguments
+            PARSE_STATS_PHASE(namedPhase, st, PHASE_NAMED);
+            const size_t groupBegin = nextArg;
+            const size_t groupEnd   = plan.groupEnd(groupBegin);
+            nextArg = groupEnd;
 
             //Keep parsing named arguments until we can't get any more
             bool foundMatch = true;
-            while(args.size() >= 2 && foundMatch){
+            while(! args.empty() && foundMatch){
 
-                //Create a dummy argument to search for
-                const std::string key = std::string(args.front());
-                args.pop_front();
-                struct Arg dummy;
-                dummy.name = key;
+                if(hasFlags &&
+                    consumeFlagToken(args.front(), classes[args.begin() - base], validateOnly)){
+                    if(record != NULL){
+                        record->addFlag(args.front());
+                    }
+                    args.popFront();
+                    continue;
+                }
 
-                //Check if we have a match
-                std::set<struct Arg>::iterator itr = namedArgParserList.find(dummy);
-                foundMatch = itr != namedArgParserList.end();
+                //Look up the key.  It is only consumed if it names an argument in this
+                //group that has not been seen yet.
+                int ambiguous = -1;
+                const int idx = lookupToken(args.front(), classes[args.begin() - base],
+                    &ambiguous);
+                if(ambiguous >= 0){
+                    errors.add(PARSE_ERR_AMBIGUOUS, ambiguous, (int)(args.begin() - base),
+                        args.front());
+                    return failed();
+                }
+                //A list's name may be the last token(the list is then empty, as it is when
+                //another name follows); any other name needs a value after it
+                foundMatch = idx >= (int)groupBegin && idx < (int)groupEnd && !consumed.test(idx) &&
+                    (args.size() >= 2 || plan.list(idx));
                 if(foundMatch){
-                    std::string errStr = "";
-                    const bool success = itr->parser->parseArg(args, itr->var, errStr);
+                    args.popFront();
+                    PARSE_STATS_ARG(argCost, st, idx);
+                    std::string errStr;
+                    bool outOfRange = false;
+                    const std::string_view* before = args.begin();
+                    bool success = true;
+                    if(plan.lazy(idx) && ! validateOnly){
+                        //Just remember the token; it is converted on first use
+                        ((LazyArgBase*)plan.var(idx))->record(args.front());
+                        args.popFront();
+                    }else if(plan.list(idx)){
+                        success = parseListArg(idx, args, classes + (args.begin() - base), errStr,
+                            validateOnly);
+                    }else if(plan.lazy(idx)){
+                        success = convertArg(idx, ((LazyArgBase*)plan.var(idx))->valueStorage(),
+                            args, errStr, true, outOfRange);
+                    }else{
+                        success = convertArg(idx, plan.var(idx), args, errStr, validateOnly,
+                            outOfRange);
+                    }
                     if(!success){
-                        errs.push_back(errStr);
-                        return ERROR;
+                        addParserError(errors, idx, base, before, args, errStr, outOfRange);
+                        return failed();
                     }
-                    namedArgParserList.erase(itr);
+                    if(record != NULL){
+                        recordArg(*record, idx, before, args.begin());
+                    }
+                    consumed.set(idx);
                 }
             }
 
-            //Make sure that the only named arguments left are optional
+            PARSE_STATS_END(namedPhase);
+
+            //Fill in what we can from the fallbacks, then make sure that the only named
+            //arguments left are optional
+            PARSE_STATS_PHASE(requiredPhase, st, PHASE_REQUIRED_CHECK);
             bool missedAtLeastOneArg = false;
-            for(std::set<struct Arg>::iterator leftItr = namedArgParserList.begin();
-                leftItr != namedArgParserList.end(); leftItr++){
-                if(! leftItr->optional){
-                    errs.push_back("No value specified for required named argument " + leftItr->name);
-                    missedAtLeastOneArg = true;
+            if(useFallbacks){
+                for(size_t i = groupBegin; i < groupEnd; i++){
+                    if(! consumed.test(i)){
+                        const FallbackResult res = applyFallback(i, fallback, errors, validateOnly);
+                        if(res == FALLBACK_ERROR){
+                            return failed();
+                        }else if(res == FALLBACK_USED){
+                            if(record != NULL){
+                                recordArg(*record, i, &fallback.usedText, &fallback.usedText + 1);
+                            }
+                            consumed.set(i);
+                        }
+                    }
                 }
             }
+            //A word at a time, since big groups are usually almost all optional
+            const uint64_t* required = plan.requiredWords();
+            for(size_t i = consumed.findMissing(required, groupBegin, groupEnd); i < groupEnd;
+                i = consumed.findMissing(required, i + 1, groupEnd)){
+                errors.add(PARSE_ERR_MISSING_REQUIRED, (int)i, -1, std::string_view());
+                missedAtLeastOneArg = true;
+            }
             if(missedAtLeastOneArg){
-                return ERROR;
+                return failed();
             }
 
 
         }
     }
 
-    //Make sure we matched all the non-named arguments
+    //Make sure we matched all the non-named arguments(the fallbacks may fill some in)
+    PARSE_STATS_PHASE(requiredPhase, st, PHASE_REQUIRED_CHECK);
     bool noErr = true;
-    for(std::list<struct Arg>::iterator it = mArgList.begin(); it != mArgList.end(); it++){
-        if(! it->optional){
-            noErr = false;
-            std::string tstr = it->named ? "named" : "positional";
-            errs.push_back("Did not match " + tstr + " argument: " + it->name);
+    for(size_t i = nextArg; i < numArgs && useFallbacks; i++){
+        const FallbackResult res = applyFallback(i, fallback, errors, validateOnly);
+        if(res == FALLBACK_ERROR){
+            return failed();
+        }else if(res == FALLBACK_USED){
+            if(record != NULL){
+                recordArg(*record, i, &fallback.usedText, &fallback.usedText + 1);
+            }
+            consumed.set(i);
         }
     }
-    return noErr ? SUCCESS : ERROR;
-}
+    const uint64_t* required = plan.requiredWords();
+    for(size_t i = consumed.findMissing(required, nextArg, numArgs); i < numArgs;
+        i = consumed.findMissing(required, i + 1, numArgs)){
+        noErr = false;
+        errors.add(PARSE_ERR_UNMATCHED, (int)i, -1, std::string_view());
+    }
+    if(noErr && ! sch.rules.empty()){
+        noErr = sch.rules.check(consumed.data(), errors);
+    }
+    PARSE_STATS_END(requiredPhase);
 
+    if(hasSubcommands && noErr){
+        if(subcommand < 0){
+            errors.add(PARSE_ERR_MISSING_SUBCOMMAND, -1, -1, std::string_view());
+            return failed();
+        }
+        //Help before the verb is for this parser
+        if(askedForHelp(numOwnTokens)){
+            return HELP_PRINTED;
+        }
+        //Hand the tokens after the verb to the verb's parser
+        const CommandLineParser& sub = subcommandParser((size_t)subcommand);
+        if(! validateOnly){
+            if(sch.subcommandVar != NULL){
+                *sch.subcommandVar = sch.subcommands[subcommand]->verb;
+            }
+            sub.resetLazyArguments();
+        }
+        const CommandLineParser* source = errors.getSource();
+        const int offset = errors.getTokenOffset();
+        errors.setSource(&sub, offset + (int)(args.begin() - base));
+        if(record != NULL){
+            record->addSubcommand((size_t)subcommand, sub.schemaFingerprint());
+        }
+        const ParseDoneStatus status = sub.parseTokens(args, errors, os, validateOnly, resource,
+            record);
+        errors.setSource(source, offset);
+        return status;
+    }
+    return noErr ? SUCCESS : failed();
+}
 
-void CommandLineParser::printHelpMessage(const std::string& appName, std::ostream& os)const{
+std::string CommandLineParser::formatError(const ParseErrorRecord& rec, const std::string& tok)const{
+    const Schema& sch = *schema;
+    if(rec.argId < 0 || rec.argId >= (int)sch.orderedArgs.size()){
+        return std::string();
+    }
+    const struct Arg& arg = sch.orderedArgs[rec.argId];
+    switch(rec.code){
+        case PARSE_ERR_MISSING_VALUE:
+            return "No values given for list argument " + arg.name;
+        case PARSE_ERR_MISSING_REQUIRED:
+            return "No value specified for required named argument " + arg.name;
+        case PARSE_ERR_UNMATCHED:
+            return std::string("Did not match ") + (arg.named ? "named" : "positional") +
+                " argument: " + arg.name;
+        case PARSE_ERR_OUT_OF_RANGE:
+            return rangeMessage((size_t)rec.argId, tok);
+        case PARSE_ERR_REQUIRES:
+            return "Argument " + arg.name + " requires argument " +
+                sch.orderedArgs[rec.relatedArgId].name + ".";
+        case PARSE_ERR_EXCLUDES:
+            return "Arguments " + arg.name + " and " + sch.orderedArgs[rec.relatedArgId].name +
+                " can't be given together.";
+        case PARSE_ERR_AMBIGUOUS:{
+            //Only the first candidate is recorded; look the rest up again
+            std::vector<int> candidates;
+            sch.nameTrie.findPrefix(tok, candidates);
+            std::string list;
+            for(size_t i = 0; i < candidates.size(); i++){
+                list += " " + sch.orderedArgs[candidates[i]].name;
+            }
+            return "Argument " + tok + " is ambiguous; it could be any of:" + list;
+        }
+        default:
+            return std::string();
+    }
+}
 
-    //String to print to indicate that something must be specified
-    const std::string BLANK_SPOT_STR("___");
+bool CommandLineParser::setCompletionChoices(const std::string& argName,
+    const std::vector<std::string>& choices){
+    const int idx = schema->argNames.find(argName);
+    Schema* sch = idx >= 0 ? mutableSchema() : NULL;
+    if(sch == NULL){
+        return false;
+    }
+    Schema::Choices* entry = NULL;
+    for(size_t i = 0; i < sch->choices.size(); i++){
+        if(sch->choices[i].argIdx == (size_t)idx){
+            entry = &sch->choices[i];
+        }
+    }
+    if(entry == NULL){
+        sch->choices.push_back(Schema::Choices());
+        entry = &sch->choices.back();
+        entry->argIdx = (size_t)idx;
+    }
+    entry->values = choices;
+    entry->trie   = ArgTrie();
+    for(size_t i = 0; i < choices.size(); i++){
+        entry->trie.insert(choices[i], (int)i);
+    }
+    return true;
+}
 
-    //Spacing string between positional arguments and regions of named arguments
-    const std::string EXTRA_SPACING("   ");
+bool CommandLineParser::handleCompletionRequest(int argc, char** argv, std::ostream& os)const{
+    const std::string_view request(argv[1]);
+    if(request == "--__complete"){
+        std::vector<std::string_view> words(argv + 2, argv + argc);
+        printCompletions(words.data(), words.size(), os);
+        return true;
+    }else if(request == "--__completion-script" && argc >= 3){
+        const std::string_view shell(argv[2]);
+        if(shell == "bash" || shell == "zsh" || shell == "fish"){
+            printCompletionScript(shell == "bash" ? SHELL_BASH : (shell == "zsh" ? SHELL_ZSH : SHELL_FISH), os);
+            return true;
+        }
+    }
+    return false;
+}
 
-    //Determine the max number of padding characters we need so that everything
-    //lines up when printed out
-    size_t wPad = 0;
-    for(size_t i = 0; i < orderedArgs.size(); i++){
-        wPad = std::max<size_t>(orderedArgs[i].name.size(), wPad);
+void CommandLineParser::printChoices(size_t argIdx, std::string_view partial, std::ostream& os)const{
+    for(size_t i = 0; i < schema->choices.size(); i++){
+        const Schema::Choices& c = schema->choices[i];
+        if(c.argIdx == argIdx){
+            std::vector<int> found;
+            c.trie.findPrefix(partial, found);
+            for(size_t j = 0; j < found.size(); j++){
+                os << c.values[found[j]] << '\n';
+            }
+        }
     }
-    //the iomanip setw function takes an int as a padding size, but string length is given
-    //as a size_t type(typically unsigned)
-    //the below statement ensures that we convert size_t to int properly, even though it is
-    //totally ridiculous to assume that the max string length in our list could ever exceed INT_MAX
-    int pad = wPad > INT_MAX ? INT_MAX : (int)wPad;
+}
 
+void CommandLineParser::printCompletions(const std::string_view* words, size_t numWords,
+    std::ostream& os)const{
 
-    //Print basic usage line
-    bool prevWasPositional = false;
-    int optCount = 0;
-    os << "usage: " << appName << " ";
-    if(hasHelpMesage()){
-        ++optCount;
-        os << "[--help] ";
-        prevWasPositional = false;
-    }
-    std::vector<size_t> namedIndices, positionalIndices;
-    for(size_t i = 0; i < orderedArgs.size(); i++){
+    const Schema& sch = *schema;
+    const size_t numArgs = sch.orderedArgs.size();
+    const std::string_view partial = numWords > 0 ? words[numWords - 1] : std::string_view();
 
-        //Create string to print representing the current argument
-        std::string nameStr = orderedArgs[i].named ?
-            (orderedArgs[i].name + " " + BLANK_SPOT_STR) :
-            (orderedArgs[i].name);
-        if(orderedArgs[i].optional){
-            nameStr = "[" + nameStr + "]";
+    //Replay the words before the cursor to find out what the partial word is
+    std::vector<bool> used(numArgs, false);
+    size_t positionalSeen = 0; //Number of positional values so far
+    int expecting = -1;        //Named argument whose value comes next
+    const bool hasFlags = ! sch.flags.empty();
+    size_t numPositional = 0; //Once this many positional values are in, a verb may follow
+    for(size_t i = 0; i < numArgs; i++){
+        numPositional += sch.orderedArgs[i].named ? 0 : 1;
+    }
+    for(size_t w = 0; w + 1 < numWords; w++){
+        if(expecting >= 0 && ! sch.orderedArgs[expecting].list){
+            expecting = -1; //This word was the value
+            continue;
         }
+        if(hasFlags && consumeFlagToken(words[w], classifyArgToken(words[w]), true)){
+            expecting = -1; //A flag ends a list, and is not a positional value
+            continue;
+        }
+        const int verb = expecting < 0 && positionalSeen >= numPositional ?
+            sch.subcommandNames.find(words[w]) : -1;
+        if(verb >= 0){
+            //The rest of the words belong to the verb
+            subcommandParser((size_t)verb).printCompletions(words + w + 1, numWords - w - 1, os);
+            return;
+        }
+        const int idx = lookupName(words[w]);
+        if(idx >= 0 && sch.orderedArgs[idx].named){
+            used[idx] = true;
+            expecting = idx;
+        }else if(expecting < 0){
+            ++positionalSeen;
+        }
+    }
 
-        //Print the argument
-        os << nameStr << " ";
+    //Values for a single valued named argument
+    if(expecting >= 0 && ! sch.orderedArgs[expecting].list){
+        printChoices((size_t)expecting, partial, os);
+        return;
+    }
 
-        //Print extra spacing if we are moving from a region of named
-        //arguments to a region of positional arguments or vice versa
-        const bool currIsPositional = ! orderedArgs[i].named;
-        if(currIsPositional ^ prevWasPositional){
-            os << EXTRA_SPACING;
-            prevWasPositional = currIsPositional;
+    //Values for a list argument, or for the positional argument under the cursor
+    if(expecting >= 0){
+        printChoices((size_t)expecting, partial, os);
+    }else{
+        size_t positional = 0;
+        for(size_t i = 0; i < numArgs; i++){
+            if(! sch.orderedArgs[i].named){
+                if(positional == positionalSeen || (sch.orderedArgs[i].list && positional <= positionalSeen)){
+                    printChoices(i, partial, os);
+                    break;
+                }
+                ++positional;
+            }
         }
+    }
 
-        //Add to indices lists
-        if(orderedArgs[i].named){
-            namedIndices.push_back(i);
-        }else{
-            positionalIndices.push_back(i);
+    //Names of the named arguments not given yet
+    std::vector<int> found;
+    sch.nameTrie.findPrefix(partial, found);
+    for(size_t i = 0; i < found.size(); i++){
+        if(! used[found[i]]){
+            os << sch.orderedArgs[found[i]].name << '\n';
+        }
+    }
+    //Verbs, once our own positional arguments are in.  Only their names are needed, so no
+    //verb's parser is built.
+    if(expecting < 0 && positionalSeen >= numPositional){
+        for(size_t i = 0; i < sch.subcommands.size(); i++){
+            const std::string& verb = sch.subcommands[i]->verb;
+            if(std::string_view(verb).substr(0, partial.size()) == partial){
+                os << verb << '\n';
+            }
         }
-
     }
-    os << std::endl << std::endl;
 
-    //Print info on what syntax means
-    if(optCount > 0 || ! namedIndices.empty()){
-        os << "Notation: " << std::endl;
-        if(optCount > 0){
-            os << "\t[...] indicates that an argument is optional." << std::endl;
+    //Flags, with the negated form of the long ones.  They may be given more than once.
+    for(size_t i = 0; i < sch.flags.size(); i++){
+        const Schema::Flag& flag = sch.flags[i];
+        if(! flag.longName.empty()){
+            const size_t numDashes = flag.longName.find_first_not_of('-');
+            const std::string negatedName = flag.longName.substr(0, numDashes) + "no-" +
+                flag.longName.substr(numDashes);
+            if(std::string_view(flag.longName).substr(0, partial.size()) == partial){
+                os << flag.longName << '\n';
+            }
+            if(std::string_view(negatedName).substr(0, partial.size()) == partial){
+                os << negatedName << '\n';
+            }
         }
-        if(! namedIndices.empty()){
-            os << "\t" << BLANK_SPOT_STR << " indicates that a value must be placed here." << std::endl;
+        const char shortName[2] = {'-', flag.shortName};
+        if(flag.shortName != '\0' && std::string_view(shortName, 2).substr(0, partial.size()) == partial){
+            os << '-' << flag.shortName << '\n';
         }
-        os << std::endl;
     }
+    if(sch.hasHelpMesage() && std::string_view("--help").substr(0, partial.size()) == partial){
+        os << "--help" << '\n';
+    }
+}
 
-    //Print short help message
-    if(hasHelpMesage()){
-        os << helpMsg << std::endl << std::endl;
+void CommandLineParser::printCompletionScript(CompletionShell shell, std::ostream& os)const{
+    //The command to complete is the binary's basename; shell function names can't contain
+    //most punctuation, so the function is named after a sanitized copy
+    const std::string& appName = schema->appName;
+    const size_t slash = appName.find_last_of("/\\");
+    const std::string command = slash == std::string::npos ? appName : appName.substr(slash + 1);
+    std::string func = "_";
+    for(size_t i = 0; i < command.size(); i++){
+        func += isalnum((unsigned char)command[i]) ? command[i] : '_';
     }
+    func += "_complete";
+
+    switch(shell){
+        case SHELL_BASH:
+            os << func << "() {\n"
+               << "    local IFS=$'\\n'\n"
+               << "    COMPREPLY=( $(\"${COMP_WORDS[0]}\" --__complete \"${COMP_WORDS[@]:1:COMP_CWORD}\" 2>/dev/null) )\n"
+               << "}\n"
+               << "complete -o default -F " << func << " " << command << "\n";
+            break;
+        case SHELL_ZSH:
+            os << "#compdef " << command << "\n"
+               << func << "() {\n"
+               << "    local -a candidates\n"
+               << "    candidates=(\"${(@f)$(\"${words[1]}\" --__complete \"${(@)words[2,CURRENT]}\" 2>/dev/null)}\")\n"
+               << "    compadd -a candidates\n"
+               << "}\n"
+               << "compdef " << func << " " << command << "\n";
+            break;
+        case SHELL_FISH:
+            os << "function " << func << "\n"
+               << "    set -l tokens (commandline -opc)\n"
+               << "    set -l current (commandline -ct)\n"
+               << "    $tokens[1] --__complete $tokens[2..-1] \"$current\" 2>/dev/null\n"
+               << "end\n"
+               << "complete -c " << command << " -f -a '(" << func << ")'\n";
+            break;
+    }
+}
 
-    //Print off info for each type of argument
-    //    positional arguments
-    if(positionalIndices.size() > 0){
-        os << "Positional arguments: " << std::endl;
-        for(size_t i = 0; i < positionalIndices.size(); i++){
-            size_t idx = positionalIndices[i];
-            os << "\t" << std::setw(pad) << orderedArgs[idx].name << "\t" <<
-                orderedArgs[idx].helpTxt << std::endl;
+void CommandLineParser::printHelpMessage(const std::string& appName, std::ostream& os)const{
+    const std::vector<struct Arg>& orderedArgs = schema->orderedArgs;
+    std::vector<ArgUsage> usage(orderedArgs.size());
+    for(size_t i = 0; i < orderedArgs.size(); i++){
+        usage[i].name     = orderedArgs[i].name;
+        usage[i].helpTxt  = orderedArgs[i].helpTxt;
+        usage[i].optional = orderedArgs[i].optional;
+        usage[i].named    = orderedArgs[i].named;
+    }
+    printUsageMessage(os, appName, schema->helpMsg, usage.data(), usage.size());
+
+    //Flags are not in the usage line; list them on their own
+    const std::vector<Schema::Flag>& flags = schema->flags;
+    if(! flags.empty()){
+        std::vector<std::string> names(flags.size());
+        size_t pad = 0;
+        bool anyNegatable = false;
+        for(size_t i = 0; i < flags.size(); i++){
+            if(flags[i].shortName != '\0'){
+                names[i] = std::string("-") + flags[i].shortName;
+            }
+            if(! flags[i].longName.empty()){
+                names[i] += (names[i].empty() ? "" : ", ") + flags[i].longName;
+                anyNegatable = true;
+            }
+            pad = std::max(pad, names[i].size());
+        }
+        os << std::endl << "Flags: " << std::endl;
+        for(size_t i = 0; i < flags.size(); i++){
+            os << "\t" << std::setw((int)pad) << names[i] << "\t" << flags[i].helpTxt << std::endl;
+        }
+        os << std::endl << "\tShort flags can be combined, as in -abc.";
+        if(anyNegatable){
+            os << "  --no-<name> turns a long flag off.";
         }
         os << std::endl;
     }
-    //    named arguments
-    if(namedIndices.size() > 0){
-        os << "Named arguments: " << std::endl;
-        for(size_t i = 0; i < namedIndices.size(); i++){
-            size_t idx = namedIndices[i];
-            os << "\t" << std::setw(pad) << orderedArgs[idx].name << "\t" <<
-                orderedArgs[idx].helpTxt <<
-                (orderedArgs[idx].optional ? "  Optional." : "  Required.") << std::endl;
+
+    //List the subcommands from what was given to appendSubcommand, without building them
+    const std::vector<std::shared_ptr<Schema::Subcommand> >& subs = schema->subcommands;
+    if(! subs.empty()){
+        size_t pad = 0;
+        for(size_t i = 0; i < subs.size(); i++){
+            pad = std::max(pad, subs[i]->verb.size());
         }
-        os << std::endl << "\tNote that multiple adjacent named arguments can be " <<
-            "specified in any order." << std::endl;
+        os << std::endl << "Commands: " << std::endl;
+        for(size_t i = 0; i < subs.size(); i++){
+            os << "\t" << std::setw((int)pad) << subs[i]->verb << "\t" << subs[i]->helpTxt << std::endl;
+        }
+        os << std::endl << "\tUse \"" << appName << " <command> --help\" for the arguments of a command." <<
+            std::endl;
     }
 }
-
-
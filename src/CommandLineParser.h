@@ -3,11 +3,28 @@
 
 #include <string>
 #include <list>
-#include <set>
 #include <vector>
 #include <iostream>
+#include <memory_resource>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <type_traits>
 //--
 #include "ArgParser.h"
+#include "ArgNameTable.h"
+#include "LazyArg.h"
+#include "IncludedArgParsers.h"
+#include "ArgStream.h"
+#include "ArgValueCodec.h"
+#include "ArgTrie.h"
+#include "ParseStats.h"
+#include "ParseErrors.h"
+#include "ArgClassify.h"
+#include "ParsePlan.h"
+#include "Subcommand.h"
+#include "ArgRules.h"
+#include "ParseSnapshot.h"
 
 
 /**
@@ -44,14 +61,33 @@ public:
     virtual ~CommandLineParser();
 
     /**
-     *  Overloaded assignment operator.  Deep copy.
+     *  Copies and moves are O(1): the argument list(the "schema") is reference counted and
+     *  shared between copies.  A copy that is modified with one of the append* functions
+     *  first takes a private copy of the schema, so copies never see each other's changes.
+     *  The variables appended to a parser ARE shared between copies, since copies hold the
+     *  same pointers.
      */
+    CommandLineParser(const CommandLineParser& other);
+    CommandLineParser(CommandLineParser&& other);
     CommandLineParser& operator=(const CommandLineParser& rhs);
+    CommandLineParser& operator=(CommandLineParser&& rhs);
 
     /**
-     *  Overloaded copy constructor.  Deep copy.
+     *  Make the schema immutable.  After this, append* and setResponseFileMode fail(or do
+     *  nothing), and the parser is a cheap handle to a reference counted, read-only schema that
+     *  can be handed to any number of threads.  Copies of a frozen parser are frozen too.
      */
-    CommandLineParser(const CommandLineParser& other);
+    void freeze();
+    inline bool isFrozen()const{ return frozen; }
+
+    /**
+     *  Record where parse spends its time and allocations in "stats"(see ParseStats.h), or stop
+     *  recording if stats is NULL.  Only has an effect in builds with CMD_PARSE_STATS defined.
+     *  The ParseStats is not owned by the parser and must outlive it(or be unset).  Copies of
+     *  this parser record into the same ParseStats.  parseBatch never records.
+     */
+    inline void setParseStats(ParseStats* parseStats){ stats = parseStats; }
+    inline ParseStats* getParseStats()const{ return stats; }
 
     /**
      *  Status returned from the parse method.  ERROR indicates that
@@ -68,10 +104,223 @@ public:
      *
      *  If the user wants to print a help message(and once was provided) this
      *  method will print to the sream outStream.  outStream defaults to std::cout.
+     *
+     *  parse does not modify the CommandLineParser, but it does write to every variable that
+     *  was appended.  Concurrent calls are therefore only safe if nothing else reads or writes
+     *  those variables at the same time; use parseBatch to check many command lines at once.
      */
      ParseDoneStatus parse(int argc, char** argv, std::list<std::string>& errs,
         std::ostream& outStream = std::cout)const;
 
+    /**
+     *  Same as parse above, except that every transient allocation made during the parse
+     *  (the token list, bookkeeping, response file storage) comes from "resource."  Pass a
+     *  ParseArena(see ParseArena.h) to throw all of it away in a single release, or a strict
+     *  ParseArena to guarantee that a successful parse never touches the global heap.  If
+     *  "resource" runs out of memory the parse fails with an error.
+     *
+     *  Not covered: the error messages added to "errs," the values written to string
+     *  variables, custom ArgParsers that allocate(including GenericParser<T> for types without
+     *  an allocation free ArgValueTraits), and printing the help message.
+     *
+     *  Large response files are tokenized on the calling thread only, since the threaded
+     *  tokenizer needs heap scratch space.
+     *
+     *  The plain parse overload runs on a small stack arena, so short command lines don't
+     *  allocate either.
+     */
+    ParseDoneStatus parse(int argc, char** argv, std::list<std::string>& errs,
+        std::pmr::memory_resource* resource, std::ostream& outStream = std::cout)const;
+
+    /**
+     *  Same as the two parse functions above, but errors are recorded as ParseErrorRecords(see
+     *  ParseErrors.h) instead of messages.  Rejecting a command line then costs a few words per
+     *  error in a buffer that "errors" reserved up front; messages are only formatted if
+     *  ParseErrors::message is called.  The std::list<std::string> versions are adapters over
+     *  these.  "errors" is not cleared first.
+     */
+    ParseDoneStatus parse(int argc, char** argv, ParseErrors& errors,
+        std::ostream& outStream = std::cout)const;
+    ParseDoneStatus parse(int argc, char** argv, ParseErrors& errors,
+        std::pmr::memory_resource* resource, std::ostream& outStream = std::cout)const;
+
+    /**
+     *  Parse the named(and any leading positional) arguments from argv as usual, then read the
+     *  trailing positional arguments from the file descriptor "fd" instead of argv, handing
+     *  each one to "sink" as it arrives.  This is meant for pipelines such as
+     *  "find . -print0 | tool --verbose true", where there may be far too many inputs for argv
+     *  and processing should start before the producer finishes.  Memory use does not grow
+     *  with the number of streamed arguments; see ArgStreamReader.
+     *
+     *  The stream is only read if argv parsed successfully.  An error from the stream is
+     *  prefixed with the index of the argument that caused it.
+     *  @param fd is the file descriptor to read, usually 0(stdin).
+     *  @param sink receives the streamed arguments.  Typically a TypedArgStreamSink.
+     *  @param delim says how the streamed arguments are separated.
+     */
+    ParseDoneStatus parseStreaming(int argc, char** argv, std::list<std::string>& errs,
+        int fd, ArgStreamSink& sink, ArgStreamReader::Delimiter delim = ArgStreamReader::DELIM_AUTO,
+        std::ostream& outStream = std::cout)const;
+
+    /**
+     *  Same as parse(argc, argv, errs, outStream), and on success also puts a snapshot of the
+     *  result in "snapshot"(see ParseSnapshot.h).  Other processes with the same argument list
+     *  can load it(see loadSnapshot and setSnapshotOption) instead of parsing the same command
+     *  line again.  Values of the common kinds are stored in binary and copied straight into
+     *  the variables on load; other arguments store their tokens and are converted again.
+     *  Values that came from the environment or the config file are part of the snapshot.
+     *  @param snapshot is cleared, and only filled if the status is SUCCESS.
+     */
+    ParseDoneStatus writeSnapshot(int argc, char** argv, std::string& snapshot,
+        std::list<std::string>& errs, std::ostream& outStream = std::cout)const;
+
+    /**
+     *  Fill the variables from a snapshot made by writeSnapshot, exactly as the parse that
+     *  made it did.  The whole snapshot is checked before anything is written, so on failure
+     *  no variable has changed.
+     *  @param source is the path of the snapshot, or the number of a file descriptor it can be
+     *   read from(as in "3").  Descriptors are opened through /dev/fd, so only on systems
+     *   that have it.  Regular files are memory mapped.
+     *  @param err describes what went wrong on failure.
+     *  @return false if the snapshot can't be read, was made for a different argument list
+     *   (its fingerprint doesn't match schemaFingerprint), or no longer converts.
+     */
+    bool loadSnapshot(const std::string& source, std::string& err)const;
+
+    /**
+     *  Have parse load snapshots: when argv[1] is "optionName," argv[2] is the source of a
+     *  snapshot(see loadSnapshot), and parse fills the variables from it and returns SUCCESS
+     *  without looking at the rest of argv.  If the snapshot can't be used, parse quietly
+     *  parses argv[3] onwards instead.  A supervisor can therefore start its workers with
+     *  "--from-snapshot 3 <the full command line>" and a worker whose argument list changed
+     *  still starts correctly.  Off by default.
+     *  @param optionName is usually "--from-snapshot."  Must be a valid, unused argument name.
+     *  @return true on success, false if the name is taken or invalid, or the parser is frozen.
+     */
+    bool setSnapshotOption(const std::string& optionName);
+
+    /**
+     *  How parse treats arguments of the form "@path."  See setResponseFileMode.
+     */
+    enum ResponseFileMode{ RESPONSE_FILES_OFF, RESPONSE_FILES_ON, RESPONSE_FILES_SHELL_QUOTED };
+
+    /**
+     *  Allow arguments to be passed in response files.  When enabled, every argument given to
+     *  parse that starts with '@' is replaced by the entries of the file it names(see
+     *  ResponseFile.h for the file format), and those entries are matched exactly as if they
+     *  had been passed in argv.  Response files are not expanded recursively, and parseBatch
+     *  does not expand them.  Off by default, since "@" may legitimately start an argument.
+     *
+     *  @param mode is RESPONSE_FILES_OFF, RESPONSE_FILES_ON, or RESPONSE_FILES_SHELL_QUOTED to
+     *   also remove shell quoting from each entry.  Ignored once the parser is frozen.
+     */
+    void setResponseFileMode(ResponseFileMode mode);
+
+    /**
+     *  Allow GNU style abbreviations of named arguments: "--verb" is taken to mean "--verbose"
+     *  as long as no other named argument starts with "--verb."  An exact name always wins, and
+     *  an abbreviation that matches more than one name is an error that lists the candidates.
+     *  Only tokens starting with '-' are treated as abbreviations.  Off by default.
+     *  Ignored once the parser is frozen.
+     */
+    void setAbbreviationsAllowed(bool allowed);
+    inline bool abbreviationsAllowed()const{ return schema->allowAbbreviations; }
+
+    /**
+     *  Arguments that are not given on the command line can fall back to an environment variable
+     *  and then to a config file(see setConfigFile).  The lookup order is argv, then the
+     *  environment, then the config file; the first one that has the argument wins.  Values
+     *  from either source are converted by the argument's ArgParser, just like argv, and a
+     *  required argument supplied by either source is satisfied.
+     *
+     *  The variable for an argument is "PREFIX_NAME": NAME is the argument name without leading
+     *  dashes, upper cased, with '-' replaced by '_'.  With prefix "MYAPP", "--log-level" is read
+     *  from MYAPP_LOG_LEVEL.
+     *  @param prefix is the prefix.  Empty(the default) turns environment lookup off.  Ignored
+     *   once the parser is frozen.
+     */
+    void setEnvironmentPrefix(const std::string& prefix);
+
+    /**
+     *  @return the environment variable consulted for "argName"(see setEnvironmentPrefix), or
+     *   an empty string if there is no environment prefix.
+     */
+    std::string environmentVariableName(const std::string& argName)const;
+
+    /**
+     *  Fall back to a "key = value" config file for arguments not given on the command line or
+     *  in the environment.  See ConfigFile.h for the format.  The file is only read when some
+     *  argument is missing from argv, and a missing or malformed file is a parse error.
+     *  @param path is the config file.  Empty(the default) turns config lookup off.
+     *  @param cachePath is an optional binary cache of the parsed config.  When the config file
+     *   has not changed since the cache was written, the values are read from the cache already
+     *   converted, skipping the text parsing and the ArgParsers.  Only values parsed by the
+     *   common ArgParsers(getCommonArgParser) are stored converted; the rest, and every lazy
+     *   or list argument, are cached as text.
+     *  Ignored once the parser is frozen.
+     */
+    void setConfigFile(const std::string& path, const std::string& cachePath = "");
+
+    /**
+     *  A hash of the argument list: names, order, kinds and the common ArgParser(if any) each
+     *  argument uses, the names and bits of the flags, and the verbs of the subcommands(but not
+     *  the verbs' own arguments, since their parsers are only built when needed).  Binary files
+     *  tied to one argument list(the config cache, snapshots) store it and are ignored when it
+     *  changes.
+     */
+    uint64_t schemaFingerprint()const;
+
+    /**
+     *  Outcome of parsing one command line with parseBatch.  The errors for the line are
+     *  errors[firstError] ... errors[firstError + numErrors - 1] in the "errors" array
+     *  that was passed to parseBatch.
+     */
+    struct BatchResult{
+        ParseDoneStatus status;
+        size_t firstError;
+        size_t numErrors;
+        unsigned worker; //Which worker thread parsed the line.  Mostly useful for debugging.
+        BatchResult() : status(SUCCESS), firstError(0), numErrors(0), worker(0) {}
+    };
+
+    /**
+     *  Validate many command lines at once, spread across a pool of worker threads.  Each line
+     *  is checked exactly like parse would check it, except that:
+     *    -Parsers are called through ArgParser::validateArg, so no appended variable is written
+     *     as long as every parser overrides validateArg.  All of the parsers in
+     *     IncludedArgParsers.h do.  A parser that doesn't(most custom parsers written against
+     *     the original interface) gets the default validateArg, which runs parseArg on the
+     *     appended variable, one call at a time across all threads.  Such variables are written
+     *     by parseBatch, and must not be read while it runs.
+     *    -No help message is printed.  A line asking for help gets the status HELP_PRINTED.
+     *    -The config file(see setConfigFile) is read once, before the workers start, and every
+     *     line falls back to that copy.  A verb's config file is still read by each line that
+     *     selects the verb.
+     *
+     *  This is safe as long as every ArgParser appended to this CommandLineParser follows the
+     *  thread safety rules in ArgParser.h.  Each worker has its own scratch buffers, so the
+     *  only shared state is a counter used to hand out lines(and the variables of parsers
+     *  that don't override validateArg, as above).
+     *
+     *  @param cmdLines are the command lines.  Each one is laid out like argv, so the first
+     *   entry(the program name) is skipped.
+     *  @param results is resized to cmdLines.size() and receives the outcome of each line.
+     *  @param errors is cleared, and receives the error messages of all lines, flattened.
+     *  @param numThreads is the number of workers.  0 means one per hardware thread.
+     */
+    void parseBatch(const std::vector<std::vector<std::string> >& cmdLines,
+        std::vector<BatchResult>& results, std::vector<std::string>& errors,
+        unsigned numThreads = 0)const;
+
+    /**
+     *  Same as parseBatch above, but the errors are records(see ParseErrors.h).  firstError and
+     *  numErrors index "errors," which is cleared first.  The tokens of the records point into
+     *  cmdLines.  No message is formatted, so rejecting a line does not allocate once the
+     *  workers' buffers have grown to fit.
+     */
+    void parseBatch(const std::vector<std::vector<std::string> >& cmdLines,
+        std::vector<BatchResult>& results, ParseErrors& errors, unsigned numThreads = 0)const;
+
     /**
      *  Enum that can be passed to getCommonArgParser() to allow easy creation of
      *  an ArgParser that is commonly used.
@@ -80,8 +329,8 @@ public:
 
     /**
      *  Return a pointer to a common type of argument parser.
-     *  Do NOT delete this pointer(this memory is managed by CommandLineParser
-     *  internally).  Typically, this function is used similar to what is shown below:
+     *  Do NOT delete this pointer.  The common parsers are process wide singletons that live
+     *  until the program exits.  Typically, this function is used similar to what is shown below:
      *
      *  CommandLineParser parser("bin/foobar");
      *  ...
@@ -93,7 +342,7 @@ public:
      *  @param parser is the type of parser you wish to get.
      *  @return a pointer to the parser.  Do NOT delete this pointer.
      */
-    const ArgParser* const  getCommonArgParser(CommonParser parser)const;
+    static const ArgParser* getCommonArgParser(CommonParser parser);
 
 
     /**
@@ -108,11 +357,31 @@ public:
      *   See getCommonArgParser() to obtain simple ArgParser for common data types.
      *  @param helpStr is an optional argument that should give a description of the argument
      *   being appended.
-     *  @return true on success, false on failure.
+     *  @return true on success, false on failure(including when the parser is frozen).
      */
     bool appendPositionalArgument(void* argVar, const std::string argName,
         const ArgParser* parser, const std::string helpStr = "");
 
+    /**
+     *  Append a positional argument whose parser is picked from the type of argVar, so the two
+     *  can't disagree:
+     *
+     *    unsigned int count;
+     *    parser.appendPositionalArgument(&count, "count", "How many to print.");
+     *
+     *  int, unsigned int, float, double, std::string and bool use the common parsers(and are
+     *  converted without a virtual call).  A std::vector of numbers takes one comma separated
+     *  token, as in "0.1,0.2,0.3"(see DelimitedListArgParser).  Any other T is converted with
+     *  ArgValueTraits<T>(see IncludedArgParsers.h).  Use the void* version above for a custom
+     *  ArgParser.
+     *  @return true on success, false on failure(including when the parser is frozen).
+     */
+    template<typename T>
+    bool appendPositionalArgument(T* argVar, const std::string argName,
+        const std::string helpStr = ""){
+        return appendArgHelper(argVar, argName, parserFor<T>(), helpStr, false, false);
+    }
+
     /**
      *  Append a named argument to the argument list.
      *  Named arguments may be optional or required.
@@ -127,11 +396,142 @@ public:
      *   if the argument must be present.  By default, named arguments are optional.
      *  @param helpStr is an optional argument that should give a description of the argument
      *   being appended.
-     *  @return true on success, false on failure.
+     *  @return true on success, false on failure(including when the parser is frozen).
      */
     bool appendNamedArgument(void* argVar, const std::string argName,
         const ArgParser* parser, bool optional = true, const std::string helpStr = "");
 
+    /**
+     *  Append a named argument whose parser is picked from the type of argVar.  See the
+     *  templated appendPositionalArgument.
+     *
+     *  The type of "optional" is a template parameter only so that a call like
+     *  appendNamedArgument(&x, "-x", parser) still means the void* version above.
+     *  @return true on success, false on failure(including when the parser is frozen).
+     */
+    template<typename T, typename Optional = bool>
+    typename std::enable_if<std::is_same<Optional, bool>::value, bool>::type
+    appendNamedArgument(T* argVar, const std::string argName, Optional optional = true,
+        const std::string helpStr = ""){
+        return appendArgHelper(argVar, argName, parserFor<T>(), helpStr, optional, true);
+    }
+
+    /**
+     *  Append a named argument that takes a list of values, as in "-inputs a.txt b.txt c.txt".
+     *  The list runs from just after the name up to the next token that is the name of an
+     *  argument(or the end of the command line), and replaces the contents of *argVar.
+     *  Each element is converted with ArgValueTraits<T>(see IncludedArgParsers.h) directly from
+     *  the argument text.
+     *  @param argVar receives the values.  Left untouched if the argument is not given.
+     *  @param argName, optional and helpStr are the same as for appendNamedArgument.
+     *  @return true on success, false on failure.
+     */
+    template<typename T>
+    bool appendNamedListArgument(std::vector<T>* argVar, const std::string argName,
+        bool optional = true, const std::string helpStr = ""){
+        return appendArgHelper(argVar, argName, ListArgParser<T>::instance(), helpStr, optional,
+            true, false, true);
+    }
+
+    /**
+     *  Append a positional argument that takes a list of values, as in "cat a.txt b.txt".
+     *  Like appendNamedListArgument, the list stops at the next token that is the name of an
+     *  argument, so this is normally the last positional argument(any positional argument after
+     *  it would never see a token).  At least one value must be given.
+     *  @return true on success, false on failure.
+     */
+    template<typename T>
+    bool appendPositionalListArgument(std::vector<T>* argVar, const std::string argName,
+        const std::string helpStr = ""){
+        return appendArgHelper(argVar, argName, ListArgParser<T>::instance(), helpStr, false,
+            false, false, true);
+    }
+
+    /**
+     *  Append a flag: an optional argument that takes no value, and sets a bit when it is
+     *  given.  The bits are packed 64 to a word, so the program can test them directly, as in
+     *  (flags[bit / 64] >> (bit % 64)) & 1.  A flag may appear anywhere on the command line
+     *  (outside the values of other arguments), and may be given more than once.
+     *
+     *  Short flags can be clustered: with flags -x, -v and -z, "-xvz" sets all three.  A long
+     *  flag "--name" also gets the negated form "--no-name", which clears the bit, so a flag
+     *  can default to on.  The bit is left alone if neither form is given.
+     *
+     *  @param flags is the array of words holding the bits.  Must outlive every parse.
+     *  @param bit is the index of this flag's bit in "flags."
+     *  @param longName is the long name, starting with '-'(usually "--name").  May be empty
+     *   if there is a short name.
+     *  @param shortName is the character of the short name("-c"), or '\0' for none.
+     *  @param helpStr is shown in the help message.
+     *  @return true on success, false if a name(or the negated name) is taken or invalid,
+     *   or the parser is frozen.
+     */
+    bool appendFlagArgument(uint64_t* flags, size_t bit, const std::string& longName,
+        char shortName = '\0', const std::string helpStr = "");
+
+    /**
+     *  Append a named argument whose value is converted on first use rather than during parse.
+     *  See LazyArg.h.  The handle records the token given for the argument, and its
+     *  ArgParser(passed to the handle's constructor) runs when the value is first asked for.
+     *  During parseBatch, the token is checked with ArgParser::validateArg as usual.
+     *  @param handle receives the token.  Must outlive every parse it is used in.
+     *  @param argName, optional and helpStr are the same as for appendNamedArgument.
+     *  @return true on success, false on failure.
+     */
+    bool appendLazyNamedArgument(LazyArgBase* handle, const std::string argName,
+        bool optional = true, const std::string helpStr = "");
+
+    /**
+     *  Convert every lazy argument given in the last parse, for programs that want bad values
+     *  reported up front.  Conversions are cached, so the handles don't convert again later.
+     *  @param errs receives one error message for each argument that fails to convert.
+     *  @return true if every lazy argument converted(or was not given), false otherwise.
+     */
+    bool materializeLazyArguments(std::list<std::string>& errs)const;
+
+    /**
+     *  Add a subcommand, as in "tool [global options] <verb> [options of the verb]."  Once a
+     *  parser has subcommands, every command line must name one of them after the parser's own
+     *  arguments, and the tokens after the verb are parsed by the verb's parser.  That parser is
+     *  built by "factory" the first time the verb is selected(see Subcommand.h).  "--help"
+     *  before the verb prints this parser's help, with the list of verbs; after the verb it
+     *  prints the verb's help.
+     *
+     *  @param verb must be a valid argument name(see isArgumentNameOK) that is not already the
+     *   name of an argument or another verb.
+     *  @param factory builds the verb's parser.  Must outlive this parser.
+     *  @param helpStr is shown next to the verb in the help message, and is the help message of
+     *   the verb's parser.
+     *  @return true on success, false on failure(including when the parser is frozen).
+     */
+    bool appendSubcommand(const std::string& verb, SubcommandFactory* factory,
+        const std::string helpStr = "");
+
+    /**
+     *  Have parse write the verb it selected to *verb.  The variable is left alone if the
+     *  command line names no verb.
+     */
+    void setSubcommandVariable(std::string* verb);
+
+    /**
+     *  Constraints between arguments, checked at the end of every parse(and parseBatch).
+     *  A broken rule is a parse error(PARSE_ERR_REQUIRES, PARSE_ERR_EXCLUDES or
+     *  PARSE_ERR_OUT_OF_RANGE in ParseErrors.h).  An argument filled in from the environment or
+     *  the config file counts as given.
+     *
+     *  addDependency: if argName is given, requiredName must be given too.
+     *  addExclusion: argName and otherName can't both be given.
+     *  setRange: the value of argName must be in [minValue, maxValue].  Only for int,
+     *   unsigned int, float and double arguments that are neither lazy nor lists.  A value out of
+     *   range is rejected before it is stored.
+     *
+     *  @return true on success, false if a name is unknown, the argument doesn't qualify or
+     *   the parser is frozen.
+     */
+    bool addDependency(const std::string& argName, const std::string& requiredName);
+    bool addExclusion(const std::string& argName, const std::string& otherName);
+    bool setRange(const std::string& argName, double minValue, double maxValue);
+
     /**
      *  Check if a given argument name is OK to be used.
      *  Names are ok if they satisfy the following properties:
@@ -151,43 +551,266 @@ public:
      */
     void printHelpMessage(const std::string& appName, std::ostream& os = std::cout)const;
 
+    /**
+     *  Shell completion.  parse answers two special first arguments itself and returns
+     *  HELP_PRINTED, so a program that calls parse before doing anything else(as it should)
+     *  exits before any of its own initialization runs:
+     *
+     *    prog --__complete WORD... PARTIAL
+     *      Prints the completions of PARTIAL, one per line.  WORD... are the words already on the
+     *      command line after the program name.  Candidates are the named arguments that have
+     *      not been used yet, the flags(and the "--no-" forms of the long ones), and the
+     *      completion choices(see setCompletionChoices) of the argument whose value is being
+     *      typed, or of the positional argument the cursor is on.  Once the positional
+     *      arguments are in, the verbs of the subcommands are candidates too(without building
+     *      their parsers), and the words after a verb are completed by the verb's parser.
+     *
+     *    prog --__completion-script bash|zsh|fish
+     *      Prints a script that hooks "prog --__complete" into the shell, e.g.
+     *      eval "$(prog --__completion-script bash)"
+     *
+     *  Names and choices are kept in prefix tries(see ArgTrie.h) built as arguments are
+     *  appended, so answering takes time proportional to the number of candidates.
+     */
+    enum CompletionShell{SHELL_BASH, SHELL_ZSH, SHELL_FISH};
+
+    /**
+     *  Give the values an argument accepts, for completion only; the argument's ArgParser still
+     *  decides what is valid.
+     *  @return false if there is no argument called argName, or the parser is frozen.
+     */
+    bool setCompletionChoices(const std::string& argName, const std::vector<std::string>& choices);
+
+    /**
+     *  Print the completions of the last entry of "words," given the entries before it.
+     *  See CompletionShell.
+     *  @param words are the words after the program name, up to and including the partial word
+     *   under the cursor(which may be empty).
+     *  @param numWords is the number of entries in words.
+     */
+    void printCompletions(const std::string_view* words, size_t numWords, std::ostream& os = std::cout)const;
+
+    /**
+     *  Print a script that makes "shell" complete this program's arguments through
+     *  "--__complete."  The script completes the command named by the basename of the
+     *  binary name the parser was created with.
+     */
+    void printCompletionScript(CompletionShell shell, std::ostream& os = std::cout)const;
+
 
 private: //--------------------------------------------------------------------
-    std::string appName;
-    std::string helpMsg;
-    inline bool hasHelpMesage()const{ return ! helpMsg.empty(); }
+    //The parser the templated append functions use for a T
+    template<typename T>
+    static const ArgParser* parserFor(){
+        static_assert(! std::is_void<T>::value, "Pass a parser to append arguments through void*");
+        if constexpr(std::is_same<T, int>::value){
+            return getCommonArgParser(AP_INT);
+        }else if constexpr(std::is_same<T, unsigned int>::value){
+            return getCommonArgParser(AP_UINT);
+        }else if constexpr(std::is_same<T, float>::value){
+            return getCommonArgParser(AP_FLOAT);
+        }else if constexpr(std::is_same<T, double>::value){
+            return getCommonArgParser(AP_DOUBLE);
+        }else if constexpr(std::is_same<T, std::string>::value){
+            return getCommonArgParser(AP_STRING);
+        }else if constexpr(std::is_same<T, bool>::value){
+            return getCommonArgParser(AP_BOOLEAN);
+        }else if constexpr(IsDelimitedListType<T>::value){
+            return DelimitedListArgParser<typename T::value_type>::instance();
+        }else{
+            return ValueArgParser<T>::instance();
+        }
+    }
 
-    std::set<std::string> usedArgNames;
     struct Arg{
         void* var;
         std::string name;
         const ArgParser* parser;
+        ArgValueKind kind; //valueKind(parser).  Common kinds are converted without a virtual call.
         std::string helpTxt;
         bool optional;
         bool named;
+        bool lazy; //var is a LazyArgBase*
+        bool list; //Takes every token up to the next argument name
+    };
+
+    //Everything that describes the command line.  Shared(read-only) between copies of a
+    //CommandLineParser, and copied on write by the append* functions.
+    struct Schema{
+        std::string appName;
+        std::string helpMsg;
+        ResponseFileMode responseFileMode;
+
+        //Every argument name(positional and named), mapped to its index in orderedArgs
+        ArgNameTable argNames;
+        std::vector<struct Arg> orderedArgs;
+        //Indices of the lazy arguments in orderedArgs
+        std::vector<size_t> lazyArgs;
+        //What parseTokens needs from orderedArgs, compiled for the parse loop
+        ParsePlan plan;
+
+        //Named argument names, for completion and abbreviations
+        ArgTrie nameTrie;
+        bool allowAbbreviations;
+        //The ArgTokenClass bits of every name OR'd together, and whether every name starts
+        //with '-'.  A token with a class no name has can't name(or abbreviate) anything.
+        uint8_t nameClasses;
+        bool allNamesDashed;
+        //Completion choices, for the arguments that have them
+        struct Choices{
+            size_t argIdx;
+            std::vector<std::string> values;
+            ArgTrie trie;
+        };
+        std::vector<Choices> choices;
+
+        //Subcommands.  Each one's parser is built on first use and shared by copies of the schema.
+        struct Subcommand{
+            std::string verb;
+            std::string helpTxt;
+            SubcommandFactory* factory;
+            std::once_flag buildOnce;
+            std::shared_ptr<CommandLineParser> parser;
+            std::atomic<bool> built; //parser may be read without going through buildOnce
+        };
+        std::vector<std::shared_ptr<Subcommand> > subcommands;
+        ArgNameTable subcommandNames;
+        std::string* subcommandVar;
+
+        //Flags(see appendFlagArgument).  flagNames maps each long and short name to 2 * its
+        //index in flags, and each negated name to 2 * index + 1.  shortFlags maps a character
+        //to the index of its short flag, or -1, for decoding clusters like "-xvzf."
+        struct Flag{
+            uint64_t* word;
+            uint64_t mask;
+            size_t bit; //As given to appendFlagArgument; word and mask come from it
+            std::string longName;
+            char shortName;
+            std::string helpTxt;
+        };
+        std::vector<Flag> flags;
+        ArgNameTable flagNames;
+        int16_t shortFlags[256];
+        bool hasShortFlags;
 
-        //We use this to sort arguments
-        inline bool operator<(const struct Arg& rhs)const{ return name < rhs.name; }
+        //Dependencies and exclusions between arguments(ranges are in the plan)
+        ArgRules rules;
 
+        //The argument that makes parse load a snapshot(see setSnapshotOption), or empty
+        std::string snapshotOption;
+
+        //Fallbacks for arguments missing from argv
+        std::string envPrefix;
+        std::string configPath;
+        std::string configCachePath;
+
+        inline bool hasHelpMesage()const{ return ! helpMsg.empty(); }
+
+        inline bool mayBeName(uint8_t tokenClass)const{
+            const uint8_t NAME_BITS = ARG_TOKEN_NUMERIC | ARG_TOKEN_EQUALS | ARG_TOKEN_INVALID;
+            return (tokenClass & NAME_BITS & ~nameClasses) == 0 &&
+                ((tokenClass & ARG_TOKEN_DASHED) != 0 || ! allNamesDashed);
+        }
     };
-    std::vector<struct Arg> orderedArgs;
+    std::shared_ptr<const Schema> schema;
+    bool frozen;
+    ParseStats* stats;
+
+    //The schema, made private to this parser first if it is shared.  NULL if frozen.
+    Schema* mutableSchema();
+
+    //Builds the token list(expanding response files) and calls parseTokens.  allowThreads
+    //lets large response files use heap allocated scratch space on several threads.  What
+    //was matched is added to *record unless record is NULL.
+    ParseDoneStatus parseWithResource(int argc, char** argv, ParseErrors& errors,
+        std::ostream& os, std::pmr::memory_resource* resource, bool allowThreads,
+        ParseSnapshot* record = NULL)const;
+
+    //Add argument idx, which was just given the tokens [begin, end), to a snapshot
+    void recordArg(ParseSnapshot& record, size_t idx, const std::string_view* begin,
+        const std::string_view* end)const;
+    //Check(or, if apply is set, write) every record of a snapshot to the variables
+    bool applySnapshot(std::string_view records, bool apply, std::string& err)const;
+
+    //The index of the argument "tok" names: an exact name, or an unambiguous abbreviation of a
+    //named argument if those are allowed.  -1 if it names nothing.  If the token abbreviates
+    //several names, returns -1 and sets *ambiguous to the first of them(otherwise it is left
+    //alone).  Never allocates.
+    int lookupName(std::string_view tok, int* ambiguous = NULL)const;
+    //Same, but skips the lookup when the token's ArgTokenClass rules out every name
+    inline int lookupToken(std::string_view tok, uint8_t tokenClass,
+        int* ambiguous = NULL)const{
+        return schema->mayBeName(tokenClass) ? lookupName(tok, ambiguous) : -1;
+    }
+
+    //If "tok" is a flag, or a cluster of short flags, set or clear their bits(unless
+    //validateOnly) and return true
+    bool consumeFlagToken(std::string_view tok, uint8_t tokenClass, bool validateOnly)const;
+
+    //The parser of subcommand i, built first if need be
+    const CommandLineParser& subcommandParser(size_t i)const;
+    //Forget what the lazy arguments recorded in the previous parse
+    void resetLazyArguments()const;
+    //Copy the tokens of the lazy arguments, here and in the subcommands built so far, into
+    //their handles
+    void pinLazyTokens()const;
 
-    void initParserTable();
+    //Answer "--__complete" and "--__completion-script."  Returns false if argv is neither.
+    bool handleCompletionRequest(int argc, char** argv, std::ostream& os)const;
+    //Print the choices of orderedArgs[argIdx] that start with "partial"
+    void printChoices(size_t argIdx, std::string_view partial, std::ostream& os)const;
 
-    //Table of default parsers
-    //TODO: Having this table here of commonly used parsers is ugly and necessitates
-    //having a deep-copy in the copy c-tor and the assignment operator.  Instead, I should
-    //refactor this code to use a static method in ArgParse to gain easy access to each of the
-    //commonly used parsers.
-    //
-    //The initial rationale behind this table was to allow the end user, who us likely creating
-    //an CommandLineParser inside of main, to avoid having to dynamically allocate simple things
-    //like FloatArgParsers and IntArgParsers.
-    ArgParser* parsers[6];
+    //The kind of value a parser produces, by identity with the common parsers
+    static ArgValueKind valueKind(const ArgParser* parser);
+
+    //Per-parse state for environment/config fallbacks, and the config file as loaded.  Defined
+    //in CommandLineParser.cpp.
+    struct FallbackState;
+    struct LoadedConfig;
+    void loadConfig(LoadedConfig& config)const;
+    enum FallbackResult{FALLBACK_NONE, FALLBACK_USED, FALLBACK_ERROR};
+
+    //Try to fill orderedArgs[idx] from the environment or the config file
+    FallbackResult applyFallback(size_t idx, FallbackState& state, ParseErrors& errors,
+        bool validateOnly)const;
+    bool applyFallbackText(size_t idx, std::string_view text, std::string& err,
+        bool validateOnly)const;
+
+    //Record that an ArgParser failed.  "before" is where the cursor was when it was called.
+    //outOfRange is set if the value parsed but is outside the argument's range.
+    void addParserError(ParseErrors& errors, int argId, const std::string_view* base,
+        const std::string_view* before, const ArgCursor& args, const std::string& errStr,
+        bool outOfRange)const;
+
+    //The message for the errors that name an argument(see ParseErrors::message)
+    friend class ParseErrors;
+    std::string formatError(const ParseErrorRecord& rec, const std::string& tok)const;
+
+    //Convert the value of argument idx, which is not a list, into "var"(validate only if
+    //validateOnly).  The common kinds skip the virtual ArgParser call.  If the argument has a
+    //range, the value is checked before it is stored, and outOfRange is set if it fails.
+    bool convertArg(size_t idx, void* var, ArgCursor& args, std::string& err,
+        bool validateOnly, bool& outOfRange)const;
+
+    //The range error message for argument idx and value text "tok"
+    std::string rangeMessage(size_t idx, const std::string& tok)const;
+
+    //Run the parser of list argument idx over the tokens up to the next argument name.
+    //classes[i] is the ArgTokenClass of args.begin()[i].
+    bool parseListArg(size_t idx, ArgCursor& args, const uint8_t* classes,
+        std::string& err, bool validateOnly)const;
+
+    //Shared by parse and parseBatch.  Prints help on *os unless os is NULL, and calls
+    //ArgParser::validateArg instead of parseArg if validateOnly is set.  Records what was
+    //matched in *record unless record is NULL.  Falls back to *config, already loaded, unless
+    //config is NULL, in which case the config file is loaded if some argument needs it.
+    ParseDoneStatus parseTokens(ArgCursor& args, ParseErrors& errors,
+        std::ostream* os, bool validateOnly, std::pmr::memory_resource* resource,
+        ParseSnapshot* record = NULL, const LoadedConfig* config = NULL)const;
 
     bool appendArgHelper(void* argVar, const std::string argName,
         const ArgParser* parser, const std::string helpStr, bool optional, bool
-        named);
+        named, bool lazy = false, bool list = false);
 };
 
 //Note:
@@ -205,6 +828,10 @@ private: //--------------------------------------------------------------------
 //
 //    See Generic_Parser<T> in IncludedArgParsers.h for some template stuff...
 //
+//    For binaries whose argument list is fixed at compile time, StaticSchema.h now provides a
+//    template based alternative: the whole argument list is one constexpr declaration, and
+//    the lookup tables and per-type conversions are generated by the compiler.
+//
 //bool appendArgument(void* ptr, const std::string& argName, (void* (*func_ptr)(std::string str) )
 //    Rejected this design because function pointers are unfamiliar to many C++ programmers,
 //    whereas inheritance is familiar to nearly everyone.  The function pointer based design might
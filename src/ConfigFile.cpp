@@ -0,0 +1,204 @@
+#include "ConfigFile.h"
+//--
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <system_error>
+#include <thread>
+#include <functional>
+//--
+#include "ArgNameTable.h"
+
+//Bump whenever the cache layout changes
+static const uint32_t CACHE_VERSION = 2; //2: lazy and list values are cached as text
+static const char CACHE_MAGIC[8] = {'C', 'L', 'P', 'C', 'A', 'C', 'H', 'E'};
+
+//Everything at the start of a cache file.  The blob follows.
+struct ConfigCacheHeader{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder; //0x01020304 as written; a cache from another byte order won't match
+    uint64_t fingerprint;
+    int64_t  mtime;
+    uint64_t fileSize;
+    uint64_t contentHash;
+    uint64_t blobSize;
+};
+
+
+static std::string_view trimConfigWhitespace(std::string_view str){
+    const char* const WS = " \t\r\n\v\f";
+    const size_t first = str.find_first_not_of(WS);
+    if(first == std::string_view::npos){
+        return std::string_view();
+    }
+    return str.substr(first, str.find_last_not_of(WS) - first + 1);
+}
+
+static std::string_view stripDashes(std::string_view name){
+    while(! name.empty() && name[0] == '-'){
+        name.remove_prefix(1);
+    }
+    return name;
+}
+
+static bool readWholeFile(const std::string& path, std::string& contents){
+    std::ifstream in(path.c_str(), std::ios::in | std::ios::binary);
+    if(! in){
+        return false;
+    }
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    contents = ss.str();
+    return true;
+}
+
+
+ConfigFile::ConfigFile() : fromCache(false) {}
+
+bool ConfigFile::load(const std::string& path, const std::string& cachePath, const Key* keys,
+    size_t numKeys, uint64_t fingerprint, std::string& err){
+
+    blob.clear();
+    entries.clear();
+    fromCache = false;
+
+    std::string text;
+    if(! readWholeFile(path, text)){
+        err = "Could not open config file " + path;
+        return false;
+    }
+
+    //What a cache for this exact file and argument list must say
+    ConfigCacheHeader want;
+    memset(&want, 0, sizeof(want));
+    memcpy(want.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    want.version     = CACHE_VERSION;
+    want.byteOrder   = 0x01020304;
+    want.fingerprint = fingerprint;
+    std::error_code ec;
+    const std::filesystem::file_time_type mtime = std::filesystem::last_write_time(path, ec);
+    want.mtime       = ec ? 0 : (int64_t)mtime.time_since_epoch().count();
+    want.fileSize    = text.size();
+    want.contentHash = ArgNameTable::hash(text);
+
+    if(! cachePath.empty()){
+        std::string cached;
+        if(readWholeFile(cachePath, cached) && cached.size() >= sizeof(ConfigCacheHeader)){
+            ConfigCacheHeader have;
+            memcpy(&have, cached.data(), sizeof(have));
+            const bool match = memcmp(have.magic, want.magic, sizeof(want.magic)) == 0 &&
+                have.version == want.version && have.byteOrder == want.byteOrder &&
+                have.fingerprint == want.fingerprint && have.mtime == want.mtime &&
+                have.fileSize == want.fileSize && have.contentHash == want.contentHash &&
+                have.blobSize == cached.size() - sizeof(ConfigCacheHeader);
+            if(match){
+                blob.assign(cached, sizeof(ConfigCacheHeader), std::string::npos);
+                if(indexBlob(numKeys)){
+                    fromCache = true;
+                    return true;
+                }
+                blob.clear();
+                entries.clear();
+            }
+        }
+    }
+
+    if(! parseText(path, text, keys, numKeys, err) || ! indexBlob(numKeys)){
+        return false;
+    }
+
+    if(! cachePath.empty()){
+        //Write to a temporary and rename, so a reader never sees half a cache.  parseBatch
+        //can get here on several threads at once, so each thread has its own temporary.
+        want.blobSize = blob.size();
+        const std::string tmpPath = cachePath + ".tmp" +
+            std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+        std::ofstream out(tmpPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        out.write((const char*)&want, sizeof(want));
+        out.write(blob.data(), (std::streamsize)blob.size());
+        out.close();
+        if(! out || std::rename(tmpPath.c_str(), cachePath.c_str()) != 0){
+            std::remove(tmpPath.c_str());
+        }
+    }
+    return true;
+}
+
+bool ConfigFile::parseText(const std::string& path, const std::string& text, const Key* keys,
+    size_t numKeys, std::string& err){
+
+    ArgNameTable table;
+    for(size_t i = 0; i < numKeys; i++){
+        table.insert(stripDashes(keys[i].name), (int)i);
+    }
+
+    size_t lineNum = 0;
+    size_t pos = 0;
+    while(pos < text.size()){
+        size_t eol = text.find('\n', pos);
+        if(eol == std::string::npos){
+            eol = text.size();
+        }
+        const std::string_view line = trimConfigWhitespace(std::string_view(text).substr(pos, eol - pos));
+        pos = eol + 1;
+        ++lineNum;
+        if(line.empty() || line[0] == '#'){
+            continue;
+        }
+
+        const std::string where = "Config file " + path + " line " + std::to_string(lineNum) + ": ";
+        const size_t eq = line.find('=');
+        if(eq == std::string_view::npos){
+            err = where + "expected key = value";
+            return false;
+        }
+        const std::string_view key = stripDashes(trimConfigWhitespace(line.substr(0, eq)));
+        std::string_view val = trimConfigWhitespace(line.substr(eq + 1));
+        if(val.size() >= 2 && (val[0] == '"' || val[0] == '\'') && val.back() == val[0]){
+            val = val.substr(1, val.size() - 2);
+        }
+        const int idx = table.find(key);
+        if(idx < 0){
+            err = where + "Argument " + std::string(key) + " is not recognized.";
+            return false;
+        }
+
+        const uint32_t argIdx = (uint32_t)idx;
+        const size_t recordStart = blob.size();
+        blob.append((const char*)&argIdx, sizeof(argIdx));
+        blob.append(sizeof(uint32_t), '\0'); //Length, filled in below
+        if(! encodeArgValue(keys[idx].kind, val, blob)){
+            err = where + "Parse error on argument: \"" + std::string(val) + "\"";
+            return false;
+        }
+        const uint32_t length = (uint32_t)(blob.size() - recordStart - 2 * sizeof(uint32_t));
+        memcpy(&blob[recordStart + sizeof(uint32_t)], &length, sizeof(length));
+    }
+    return true;
+}
+
+bool ConfigFile::indexBlob(size_t numKeys){
+    Entry none = {0, 0, false};
+    entries.assign(numKeys, none);
+    size_t pos = 0;
+    while(pos < blob.size()){
+        uint32_t argIdx, length;
+        if(blob.size() - pos < 2 * sizeof(uint32_t)){
+            return false;
+        }
+        memcpy(&argIdx, blob.data() + pos, sizeof(argIdx));
+        memcpy(&length, blob.data() + pos + sizeof(uint32_t), sizeof(length));
+        pos += 2 * sizeof(uint32_t);
+        if(argIdx >= numKeys || length > blob.size() - pos){
+            return false;
+        }
+        entries[argIdx].offset  = (uint32_t)pos;
+        entries[argIdx].length  = length;
+        entries[argIdx].present = true; //Later records win, like later lines
+        pos += length;
+    }
+    return true;
+}
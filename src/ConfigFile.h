@@ -0,0 +1,84 @@
+#ifndef CONFIG_FILE_H
+#define CONFIG_FILE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+//--
+#include "ArgValueCodec.h"
+
+/**
+ *  A "key=value" config file, loaded for one argument list.  CommandLineParser falls back
+ *  to it for arguments that were given neither on the command line nor in the environment.
+ *
+ *  File format: one "key = value" per line.  Whitespace around keys and values is ignored, as
+ *  are blank lines and lines starting with '#'.  A value may be wrapped in single or double
+ *  quotes to keep leading or trailing whitespace.  Keys are argument names, with or without
+ *  their leading dashes("-verbose = true" and "verbose = true" are the same).  A key that
+ *  appears twice keeps its last value.
+ *
+ *  Values of the common kinds(see ArgValueKind) are converted while the file is read, and
+ *  the converted values can be saved to a binary cache file.  The cache records the config
+ *  file's modification time, size and content hash, plus a fingerprint of the argument list;
+ *  when all of them still match, later loads read the cache instead of parsing the text and
+ *  converting each value again.
+ */
+class ConfigFile{
+public:
+    /// How one argument appears in the config file.
+    struct Key{
+        std::string_view name; //The argument name(leading dashes are ignored)
+        ArgValueKind kind;
+    };
+
+    ConfigFile();
+
+    /**
+     *  Load the config file at "path."
+     *  @param cachePath is where the binary cache lives.  Empty for no cache.  A missing, stale
+     *   or unreadable cache is rebuilt; failing to write it is not an error.
+     *  @param keys has one entry per argument; value(i) refers to keys[i].
+     *  @param numKeys is the number of entries in keys.
+     *  @param fingerprint identifies the argument list(and so the meaning of keys).
+     *  @param err describes what went wrong on failure.
+     *  @return true on success, false on failure.
+     */
+    bool load(const std::string& path, const std::string& cachePath, const Key* keys,
+        size_t numKeys, uint64_t fingerprint, std::string& err);
+
+    /**
+     *  @return true if the file gave a value for argument "i."
+     */
+    inline bool has(size_t i)const{ return i < entries.size() && entries[i].present; }
+
+    /**
+     *  The value for argument "i"(only valid if has(i)): the binary form for common kinds(see
+     *  decodeArgValue), the text of the value for ARG_KIND_CUSTOM.
+     */
+    inline std::string_view value(size_t i)const{
+        return std::string_view(blob.data() + entries[i].offset, entries[i].length);
+    }
+
+    /**
+     *  @return true if the last load came from the binary cache.
+     */
+    inline bool loadedFromCache()const{ return fromCache; }
+
+private:
+    struct Entry{
+        uint32_t offset;
+        uint32_t length;
+        bool present;
+    };
+    std::string blob; //Records of {uint32 arg, uint32 length, value bytes}
+    std::vector<Entry> entries;
+    bool fromCache;
+
+    bool parseText(const std::string& path, const std::string& text, const Key* keys,
+        size_t numKeys, std::string& err);
+    bool indexBlob(size_t numKeys);
+};
+
+#endif //CONFIG_FILE_H
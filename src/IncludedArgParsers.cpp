@@ -4,76 +4,109 @@
 #include <cstdlib>
 
 
-bool FloatArgParser::parseArg(std::list<std::string>& args, void* placeResultHere, std::string& err)const{
-    if(args.size() == 0){
+/// Convert the front of "args" to a T, consuming it.  Shared by all of the parsers below.
+/// The message for a bad value is only built if the caller wants it(see ArgCursor).
+template<typename T>
+static bool convertFront(ArgCursor& args, T& result, std::string& err){
+    if(args.empty()){
         err = "Argument not present.";
         return false;
     }else{
-        const std::string tmp(args.front());
-        args.pop_front();
-        const bool ret = convertFromStringToT<float>(tmp, *((float*)placeResultHere));
-        err = ret ? err : "Parse error on argument: \"" + tmp + "\"";
+        const std::string_view tmp(args.front());
+        args.popFront();
+        const bool ret = convertFromStringToT<T>(tmp, result);
+        if(! ret && args.wantsErrorText()){
+            err = "Parse error on argument: \"" + std::string(tmp) + "\"";
+        }
         return ret;
     }
 }
 
-bool DoubleArgParser::parseArg(std::list<std::string>& args, void* placeResultHere, std::string& err)const{
-    if(args.size() == 0){
-        err = "Argument not present.";
-        return false;
-    }else{
-        const std::string tmp(args.front());
-        args.pop_front();
-        const bool ret = convertFromStringToT<double>(tmp, *((double*)placeResultHere));
-        err = ret ? err : "Parse error on argument: \"" + tmp + "\"";
-        return ret;
-    }
+/// convertFront into "var," or into a temporary when var is NULL.
+template<typename T>
+static bool convertFrontTo(ArgCursor& args, void* var, std::string& err){
+    T tmp;
+    return convertFront<T>(args, var != NULL ? *((T*)var) : tmp, err);
 }
-bool IntArgParser::parseArg(std::list<std::string>& args, void* placeResultHere, std::string& err)const{
-    if(args.size() == 0){
-        err = "Argument not present.";
-        return false;
-    }else{
-        const std::string tmp(args.front());
-        args.pop_front();
-        const bool ret = convertFromStringToT<int>(tmp, *((int*)placeResultHere));
-        err = ret ? err : "Parse error on argument: \"" + tmp + "\"";
-        return ret;
+
+bool convertCommonArg(ArgValueKind kind, ArgCursor& args, void* var, std::string& err){
+    switch(kind){
+        case ARG_KIND_INT    : return convertFrontTo<int>(args, var, err);
+        case ARG_KIND_UINT   : return convertFrontTo<unsigned int>(args, var, err);
+        case ARG_KIND_FLOAT  : return convertFrontTo<float>(args, var, err);
+        case ARG_KIND_DOUBLE : return convertFrontTo<double>(args, var, err);
+        case ARG_KIND_BOOL   : return convertFrontTo<bool>(args, var, err);
+        case ARG_KIND_STRING :
+            if(var != NULL){
+                return convertFront<std::string>(args, *((std::string*)var), err);
+            }else if(args.empty()){
+                err = "Argument not present.";
+                return false;
+            }
+            args.popFront(); //Any text is a valid string
+            return true;
+        default:
+            err = "No common parser for this kind of argument.";
+            return false;
     }
 }
-bool UnsignedIntArgParser::parseArg(std::list<std::string>& args, void* placeResultHere, std::string& err)const{
-    if(args.size() == 0){
-        err = "Argument not present.";
-        return false;
-    }else{
-        const std::string tmp(args.front());
-        args.pop_front();
-        const bool ret = convertFromStringToT<unsigned int>(tmp, *((unsigned int*)placeResultHere));
-        err = ret ? err : "Parse error on argument: \"" + tmp + "\"";
-        return ret;
-    }
+
+bool FloatArgParser::parseArg(ArgCursor& args, void* placeResultHere, std::string& err)const{
+    return convertFront<float>(args, *((float*)placeResultHere), err);
 }
-bool StringArgParser::parseArg(std::list<std::string>& args, void* placeResultHere, std::string& err)const{
-    if(args.size() == 0){
-        err = "Argument not present.";
-        return false;
-    }else{
-        const std::string tmp(args.front());
-        args.pop_front();
-        *((std::string*)placeResultHere) = tmp;
-        return true;
-    }
+bool FloatArgParser::validateArg(ArgCursor& args, void* /*placeResultHere*/,
+    std::string& err)const{
+    float tmp;
+    return convertFront<float>(args, tmp, err);
+}
+
+bool DoubleArgParser::parseArg(ArgCursor& args, void* placeResultHere, std::string& err)const{
+    return convertFront<double>(args, *((double*)placeResultHere), err);
+}
+bool DoubleArgParser::validateArg(ArgCursor& args, void* /*placeResultHere*/,
+    std::string& err)const{
+    double tmp;
+    return convertFront<double>(args, tmp, err);
+}
+
+bool IntArgParser::parseArg(ArgCursor& args, void* placeResultHere, std::string& err)const{
+    return convertFront<int>(args, *((int*)placeResultHere), err);
+}
+bool IntArgParser::validateArg(ArgCursor& args, void* /*placeResultHere*/,
+    std::string& err)const{
+    int tmp;
+    return convertFront<int>(args, tmp, err);
+}
+
+bool UnsignedIntArgParser::parseArg(ArgCursor& args, void* placeResultHere, std::string& err)const{
+    return convertFront<unsigned int>(args, *((unsigned int*)placeResultHere), err);
+}
+bool UnsignedIntArgParser::validateArg(ArgCursor& args, void* /*placeResultHere*/,
+    std::string& err)const{
+    unsigned int tmp;
+    return convertFront<unsigned int>(args, tmp, err);
 }
-bool BoolArgParser::parseArg(std::list<std::string>& args, void* placeResultHere, std::string& err)const{
-    if(args.size() == 0){
+
+bool StringArgParser::parseArg(ArgCursor& args, void* placeResultHere, std::string& err)const{
+    return convertFront<std::string>(args, *((std::string*)placeResultHere), err);
+}
+bool StringArgParser::validateArg(ArgCursor& args, void* /*placeResultHere*/,
+    std::string& err)const{
+    //Any text is a valid string, so there is nothing to convert
+    if(args.empty()){
         err = "Argument not present.";
         return false;
-    }else{
-        const std::string tmp(args.front());
-        args.pop_front();
-        const bool ret = convertFromStringToT<bool>(tmp, *((bool*)placeResultHere));
-        err = ret ? err : "Parse error on argument: \"" + tmp + "\"";
-        return ret;
     }
+    args.popFront();
+    return true;
+}
+
+bool BoolArgParser::parseArg(ArgCursor& args, void* placeResultHere, std::string& err)const{
+    return convertFront<bool>(args, *((bool*)placeResultHere), err);
+}
+bool BoolArgParser::validateArg(ArgCursor& args, void* /*placeResultHere*/,
+    std::string& err)const{
+    bool tmp;
+    return convertFront<bool>(args, tmp, err);
 }
 
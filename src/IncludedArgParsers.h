@@ -2,34 +2,179 @@
 #define INCLUDED_ARG_PARSERS_H
 
 #include <string>
+#include <string_view>
 #include <list>
+#include <vector>
 #include <sstream>
+#include <charconv>
+#include <cmath>
+#include <type_traits>
+#include <utility>
 //--
 #include "ArgParser.h"
+#include "ArgValueCodec.h"
+#include "ArgClassify.h"
 
 
 /**
  *  Template helper function.
- *  Convert an arbitrary string str to an object of type T.
- *  T MUST have a properly overloaded stream extraction operator (<<)
- *  for this to work.
+ *  Convert an arbitrary string str to an object of type T using a std::istringstream.
+ *  T MUST have a properly overloaded stream extraction operator (>>)
+ *  for this to work.  This is the fallback used by ArgValueTraits for types that don't
+ *  provide a faster conversion.
  *
  *  @param str is the string to convert.
  *  @param ret is a reference through which the result is returned.
  *  @eturn true on success, false otherwise.
  */
 template<typename T>
-inline bool convertFromStringToT(const std::string& str, T& ret){
-    std::istringstream ss(str);
+inline bool streamConvertFromStringToT(std::string_view str, T& ret){
+    std::istringstream ss{std::string(str)};
     ss >> std::boolalpha; //Allow "true" and "false" for booleans;
     //and DISALLOW "1" and "0"
     ss >> std::ws >> ret >> std::ws;
     return ss.eof();
 }
 
+/**
+ *  Strip the whitespace the stream based conversion used to skip(std::ws) from both ends of "str."
+ */
+inline std::string_view trimArgWhitespace(std::string_view str){
+    const char* WS = " \t\n\v\f\r";
+    const size_t first = str.find_first_not_of(WS);
+    if(first == std::string_view::npos){
+        return std::string_view();
+    }
+    return str.substr(first, str.find_last_not_of(WS) - first + 1);
+}
+
+/**
+ *  Convert "str" to a number with std::from_chars: no locale and no allocation.  Leading and
+ *  trailing whitespace and a leading '+' are accepted, like with a stream.  Anything else
+ *  left over, an empty string, or a value that does not fit in T is an error.  Unsigned types
+ *  reject a leading '-'(a stream would silently wrap the value around).
+ */
+template<typename T>
+inline bool fromCharsConvertFromStringToT(std::string_view str, T& ret){
+    str = trimArgWhitespace(str);
+    if(str.size() > 1 && str[0] == '+' && str[1] != '-'){
+        str.remove_prefix(1);
+    }
+    if(str.empty()){
+        return false;
+    }
+    T tmp;
+    const std::from_chars_result res = std::from_chars(str.data(), str.data() + str.size(), tmp);
+    if(res.ec != std::errc() || res.ptr != str.data() + str.size()){
+        return false;
+    }
+    if constexpr(std::is_floating_point<T>::value){
+        //from_chars understands "inf" and "nan," the stream based conversion never did
+        if(! std::isfinite(tmp)){
+            return false;
+        }
+    }
+    ret = tmp;
+    return true;
+}
+
+/**
+ *  Traits class that controls how a token is converted to a T.  convertFromStringToT,
+ *  GenericParser<T> and StaticSchema all convert through ArgValueTraits<T>::fromString.
+ *
+ *  By default conversion goes through a std::istringstream(streamConvertFromStringToT).
+ *  Integers, floating point types, bool and std::string have allocation free specializations
+ *  below.  To give your own type Foo a fast path, specialize the template:
+ *
+ *    template<>
+ *    struct ArgValueTraits<Foo>{
+ *        static bool fromString(std::string_view str, Foo& ret){ ... }
+ *    };
+ *
+ *  The second template parameter exists so that specializations can be enabled for whole
+ *  families of types with std::enable_if.
+ */
+template<typename T, typename Enable = void>
+struct ArgValueTraits{
+    static bool fromString(std::string_view str, T& ret){ return streamConvertFromStringToT<T>(str, ret); }
+};
+
+/// True for the character types, which a stream reads as a single character rather than a number.
+template<typename T>
+struct IsArgCharType : std::integral_constant<bool,
+    std::is_same<T, char>::value || std::is_same<T, signed char>::value ||
+    std::is_same<T, unsigned char>::value || std::is_same<T, wchar_t>::value ||
+    std::is_same<T, char16_t>::value || std::is_same<T, char32_t>::value> {};
+
+template<typename T>
+struct ArgValueTraits<T, typename std::enable_if<std::is_integral<T>::value &&
+    ! std::is_same<T, bool>::value && ! IsArgCharType<T>::value>::type>{
+    static bool fromString(std::string_view str, T& ret){
+        const std::string_view trimmed = trimArgWhitespace(str);
+        if(std::is_unsigned<T>::value && ! trimmed.empty() && trimmed[0] == '-'){
+            return false;
+        }
+        return fromCharsConvertFromStringToT<T>(str, ret);
+    }
+};
+
+template<typename T>
+struct ArgValueTraits<T, typename std::enable_if<std::is_floating_point<T>::value>::type>{
+    static bool fromString(std::string_view str, T& ret){ return fromCharsConvertFromStringToT<T>(str, ret); }
+};
+
+/**
+ *  Only "true" and "false" are accepted; "1" and "0" are NOT.
+ */
+template<>
+struct ArgValueTraits<bool>{
+    static bool fromString(std::string_view str, bool& ret){
+        str = trimArgWhitespace(str);
+        if(str == "true"){
+            ret = true;
+            return true;
+        }else if(str == "false"){
+            ret = false;
+            return true;
+        }
+        return false;
+    }
+};
+
+/**
+ *  Strings are taken verbatim, like StringArgParser does.
+ */
+template<>
+struct ArgValueTraits<std::string>{
+    static bool fromString(std::string_view str, std::string& ret){
+        ret.assign(str.data(), str.size());
+        return true;
+    }
+};
+
+/**
+ *  Template helper function.
+ *  Convert an arbitrary string str to an object of type T through ArgValueTraits<T>.
+ *  Built in numeric types and bool use a locale free std::from_chars path; other types
+ *  need a properly overloaded stream extraction operator (>>), or an ArgValueTraits
+ *  specialization.
+ *
+ *  @param str is the string to convert.
+ *  @param ret is a reference through which the result is returned.
+ *  @eturn true on success, false otherwise.
+ */
+template<typename T>
+inline bool convertFromStringToT(std::string_view str, T& ret){
+    return ArgValueTraits<T>::fromString(str, ret);
+}
+
 /**
  *  Generic ArgParser class that can parse any type T that has a properly
- *  coded stream extraction operator.
+ *  coded stream extraction operator, or an ArgValueTraits<T> specialization.
+ *
+ *  GenericParser and all of the parsers below keep no state, so they are safe to share between
+ *  threads(see the thread safety notes in ArgParser.h).  Their validateArg converts into a
+ *  temporary and never touches placeResultHere.
  *
  *  Warning - If you attempt to instantiate a GenericParser
  *  with some type T=Foo where Foo has no stream extraction operator
@@ -37,16 +182,19 @@ inline bool convertFromStringToT(const std::string& str, T& ret){
  */
 template<typename T>
 class GenericParser : public ArgParser{
-    virtual bool parseArg(std::list<std::string>& args, void* placeResultHere, std::string& err)const{
+public:
+    using ArgParser::parseArg;
+
+    virtual bool parseArg(ArgCursor& args, void* placeResultHere, std::string& err)const{
         if(args.empty()){
             err = "No text given.";
             return false;
         }else{
-            const std::string arg = args.front();
-            args.pop_front();
+            const std::string_view arg = args.front();
+            args.popFront();
             const bool ok = convertFromStringToT<T>(arg, *((T*)placeResultHere));
             if(!ok){
-                err = "Error when parsing: " + arg;
+                err = "Error when parsing: " + std::string(arg);
                 return false;
             }else{
                 return true;
@@ -54,32 +202,256 @@ class GenericParser : public ArgParser{
         }
     }
 
+    virtual bool validateArg(ArgCursor& args, void* /*placeResultHere*/, std::string& err)const{
+        T tmp;
+        return parseArg(args, (void*)&tmp, err);
+    }
+
     virtual std::string name()const{ return "Generic_Parser"; }
 };
 
+/**
+ *  Parses EVERY token it is given into a std::vector<T>, replacing its previous contents.
+ *  CommandLineParser hands it the run of tokens up to the next argument name; see
+ *  CommandLineParser::appendNamedListArgument.  Elements are converted with ArgValueTraits<T>
+ *  straight from the token text, and the vector is sized once up front.  On a bad element the
+ *  vector keeps the elements before it, as with DelimitedListArgParser.
+ */
+template<typename T>
+class ListArgParser : public ArgParser{
+public:
+    using ArgParser::parseArg;
+
+    virtual bool parseArg(ArgCursor& args, void* placeResultHere, std::string& err)const{
+        std::vector<T>& ret = *((std::vector<T>*)placeResultHere);
+        ret.clear();
+        ret.reserve(args.size());
+        while(! args.empty()){
+            const std::string_view tok = args.front();
+            args.popFront(); //A bad element is the last token consumed(see ArgCursor)
+            T tmp; //Not ret.back(), which is a proxy for std::vector<bool>
+            if(! ArgValueTraits<T>::fromString(tok, tmp)){
+                if(args.wantsErrorText()){
+                    err = "Parse error on argument: \"" + std::string(tok) + "\"";
+                }
+                return false;
+            }
+            ret.push_back(std::move(tmp));
+        }
+        return true;
+    }
+
+    virtual bool validateArg(ArgCursor& args, void* /*placeResultHere*/, std::string& err)const{
+        while(! args.empty()){
+            const std::string_view tok = args.front();
+            args.popFront();
+            T tmp;
+            if(! ArgValueTraits<T>::fromString(tok, tmp)){
+                if(args.wantsErrorText()){
+                    err = "Parse error on argument: \"" + std::string(tok) + "\"";
+                }
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// The one instance CommandLineParser uses for vectors of T.
+    static const ListArgParser<T>* instance(){
+        static const ListArgParser<T> parser;
+        return &parser;
+    }
+};
+
+/**
+ *  Parses one token into a T with ArgValueTraits<T>.  This is what the templated
+ *  CommandLineParser::appendNamedArgument and appendPositionalArgument use for types that
+ *  don't have a common parser.  Unlike GenericParser, its error messages match the common
+ *  parsers', and are only built when the caller wants them(see ArgCursor).
+ */
+template<typename T>
+class ValueArgParser : public ArgParser{
+public:
+    using ArgParser::parseArg;
+
+    virtual bool parseArg(ArgCursor& args, void* placeResultHere, std::string& err)const{
+        return convert(args, *((T*)placeResultHere), err);
+    }
+
+    virtual bool validateArg(ArgCursor& args, void* /*placeResultHere*/, std::string& err)const{
+        T tmp;
+        return convert(args, tmp, err);
+    }
+
+    /// The one instance CommandLineParser uses for T.
+    static const ValueArgParser<T>* instance(){
+        static const ValueArgParser<T> parser;
+        return &parser;
+    }
+
+private:
+    static bool convert(ArgCursor& args, T& result, std::string& err){
+        if(args.empty()){
+            err = "Argument not present.";
+            return false;
+        }
+        const std::string_view tok = args.front();
+        args.popFront();
+        if(! ArgValueTraits<T>::fromString(tok, result)){
+            if(args.wantsErrorText()){
+                err = "Parse error on argument: \"" + std::string(tok) + "\"";
+            }
+            return false;
+        }
+        return true;
+    }
+};
+
+/**
+ *  Convert the elements of the delimited list "str"(as in "0.1,0.2,0.3") with
+ *  ArgValueTraits<T>, into out[0, numElements).  Separators are found 16 bytes at a time
+ *  (see findArgByte), and elements are converted straight from the text.
+ *  @param numElements must be countArgByte(str, delim) + 1.
+ *  @param out receives the values.  NULL to only check them.
+ *  @param badOffset receives the offset of the first bad element in str.
+ *  @return the index of the first element that does not convert, or numElements.
+ */
+template<typename T>
+size_t convertDelimitedList(std::string_view str, char delim, size_t numElements, T* out,
+    size_t& badOffset){
+    const char* const first = str.data();
+    const char* const last  = first + str.size();
+    const char* begin = first;
+    T tmp;
+    for(size_t i = 0; i < numElements; i++){
+        const char* end = findArgByte(begin, last, delim);
+        if(! ArgValueTraits<T>::fromString(std::string_view(begin, (size_t)(end - begin)),
+            out != NULL ? out[i] : tmp)){
+            badOffset = (size_t)(begin - first);
+            return i;
+        }
+        begin = end + 1;
+    }
+    return numElements;
+}
+
+/// True for the std::vectors DelimitedListArgParser handles: vectors of numbers.
+template<typename T>
+struct IsDelimitedListType : std::false_type {};
+template<typename T>
+struct IsDelimitedListType<std::vector<T> > : std::integral_constant<bool,
+    std::is_arithmetic<T>::value && ! std::is_same<T, bool>::value && ! IsArgCharType<T>::value> {};
+
+/**
+ *  Parses ONE token holding a delimited list of numbers, as in "--weights 0.1,0.2,0.3," into a
+ *  std::vector<T>, replacing its contents.  Meant for big lists(hundreds of thousands of
+ *  elements): the vector is sized once, from a vectorized count of the separators, and no
+ *  element allocates.  An empty token is an empty list; an empty element("1,,2") is an error,
+ *  and on any error the vector keeps the elements before the bad one.
+ *
+ *  The error message gives the index and offset of the first bad element.  Since a message
+ *  naming the whole token would be useless for big lists, it is built even when the caller
+ *  did not ask for text(see ArgCursor).
+ *
+ *  CommandLineParser's templated append functions use this parser, with ',' as the delimiter,
+ *  for vectors of int, unsigned int, float and double(and other arithmetic types).
+ */
+template<typename T>
+class DelimitedListArgParser : public ArgParser{
+public:
+    using ArgParser::parseArg;
+
+    explicit DelimitedListArgParser(char delimiter = ',') : delim(delimiter) {}
+
+    virtual bool parseArg(ArgCursor& args, void* placeResultHere, std::string& err)const{
+        return run(args, (std::vector<T>*)placeResultHere, err);
+    }
+
+    virtual bool validateArg(ArgCursor& args, void* /*placeResultHere*/, std::string& err)const{
+        return run(args, NULL, err);
+    }
+
+    /// The instance that splits at commas.
+    static const DelimitedListArgParser<T>* instance(){
+        static const DelimitedListArgParser<T> parser;
+        return &parser;
+    }
+
+private:
+    char delim;
+
+    bool run(ArgCursor& args, std::vector<T>* ret, std::string& err)const{
+        if(args.empty()){
+            err = "Argument not present.";
+            return false;
+        }
+        const std::string_view tok = args.front();
+        args.popFront();
+        const size_t numElements = tok.empty() ? 0 :
+            countArgByte(tok.data(), tok.data() + tok.size(), delim) + 1;
+        if(ret != NULL){
+            ret->resize(numElements);
+        }
+        size_t badOffset = 0;
+        const size_t bad = convertDelimitedList<T>(tok, delim, numElements,
+            ret != NULL ? ret->data() : NULL, badOffset);
+        if(bad == numElements){
+            return true;
+        }
+        if(ret != NULL){
+            ret->resize(bad);
+        }
+        const char* begin = tok.data() + badOffset;
+        const char* end   = findArgByte(begin, tok.data() + tok.size(), delim);
+        err = "Parse error on element " + std::to_string(bad) + "(offset " +
+            std::to_string(badOffset) + ") of list: \"" + std::string(begin, end) + "\"";
+        return false;
+    }
+};
+
+/**
+ *  Do what the common parser for "kind" does(see CommandLineParser::getCommonArgParser), without
+ *  a virtual call.  CommandLineParser uses this for arguments whose parser is a common one.
+ *  @param kind must not be ARG_KIND_CUSTOM.
+ *  @param var is where the value goes, or NULL to only validate it.
+ */
+bool convertCommonArg(ArgValueKind kind, ArgCursor& args, void* var, std::string& err);
+
 class FloatArgParser : public ArgParser{
 public:
-    virtual bool parseArg(std::list<std::string>& args, void* placeResultHere, std::string& err)const;
+    using ArgParser::parseArg;
+    virtual bool parseArg(ArgCursor& args, void* placeResultHere, std::string& err)const;
+    virtual bool validateArg(ArgCursor& args, void* placeResultHere, std::string& err)const;
 };
 class DoubleArgParser : public ArgParser{
 public:
-    virtual bool parseArg(std::list<std::string>& args, void* placeResultHere, std::string& err)const;
+    using ArgParser::parseArg;
+    virtual bool parseArg(ArgCursor& args, void* placeResultHere, std::string& err)const;
+    virtual bool validateArg(ArgCursor& args, void* placeResultHere, std::string& err)const;
 };
 class IntArgParser : public ArgParser{
 public:
-    virtual bool parseArg(std::list<std::string>& args, void* placeResultHere, std::string& err)const;
+    using ArgParser::parseArg;
+    virtual bool parseArg(ArgCursor& args, void* placeResultHere, std::string& err)const;
+    virtual bool validateArg(ArgCursor& args, void* placeResultHere, std::string& err)const;
 };
 class UnsignedIntArgParser : public ArgParser{
 public:
-    virtual bool parseArg(std::list<std::string>& args, void* placeResultHere, std::string& err)const;
+    using ArgParser::parseArg;
+    virtual bool parseArg(ArgCursor& args, void* placeResultHere, std::string& err)const;
+    virtual bool validateArg(ArgCursor& args, void* placeResultHere, std::string& err)const;
 };
 class StringArgParser : public ArgParser{
 public:
-    virtual bool parseArg(std::list<std::string>& args, void* placeResultHere, std::string& err)const;
+    using ArgParser::parseArg;
+    virtual bool parseArg(ArgCursor& args, void* placeResultHere, std::string& err)const;
+    virtual bool validateArg(ArgCursor& args, void* placeResultHere, std::string& err)const;
 };
 class BoolArgParser : public ArgParser{
 public:
-    virtual bool parseArg(std::list<std::string>& args, void* placeResultHere, std::string& err)const;
+    using ArgParser::parseArg;
+    virtual bool parseArg(ArgCursor& args, void* placeResultHere, std::string& err)const;
+    virtual bool validateArg(ArgCursor& args, void* placeResultHere, std::string& err)const;
 };
 
 #endif //INCLUDED_ARG_PARSERS_H
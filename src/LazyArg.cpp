@@ -0,0 +1,43 @@
+#include "LazyArg.h"
+
+
+LazyArgBase::LazyArgBase(const ArgParser* parser) : parser(parser), state(NOT_GIVEN) {}
+
+bool LazyArgBase::materialize(std::string& err)const{
+    if(state == RECORDED){
+        ArgCursor cursor(&span, &span + 1);
+        std::string errStr;
+        if(parser->parseArg(cursor, valueStorage(), errStr)){
+            state = CONVERTED;
+        }else{
+            state = FAILED;
+            error = errStr.empty() ? "Parse error on argument: \"" + std::string(span) + "\"" : errStr;
+        }
+    }
+    if(state == FAILED){
+        err = error;
+        return false;
+    }
+    return true;
+}
+
+void LazyArgBase::reset(){
+    state = NOT_GIVEN;
+    span  = std::string_view();
+    ownedToken.clear();
+    error.clear();
+    resetValue();
+}
+
+void LazyArgBase::record(std::string_view tok){
+    reset();
+    span  = tok;
+    state = RECORDED;
+}
+
+void LazyArgBase::pinToken(){
+    if(state != NOT_GIVEN && span.data() != ownedToken.data()){
+        ownedToken.assign(span.data(), span.size());
+        span = ownedToken;
+    }
+}
@@ -0,0 +1,128 @@
+#ifndef LAZY_ARG_H
+#define LAZY_ARG_H
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+//--
+#include "ArgParser.h"
+
+class CommandLineParser;
+
+/**
+ *  A named argument whose value is converted on first use instead of during parse.
+ *
+ *  CommandLineParser::parse normally runs every supplied value through its ArgParser straight
+ *  away.  That is wasteful for options that are only read on rare code paths and that are
+ *  expensive to convert(reading a file, decoding a blob, ...).  A lazy argument only records
+ *  the token that was given for it; the ArgParser runs the first time the value is asked for,
+ *  and the result(or the error) is cached:
+ *
+ *    LazyArg<Image> background(&imageParser);
+ *    parser.appendLazyNamedArgument(&background, "-background");
+ *    ...
+ *    parser.parse(argc, argv, errs);
+ *    if(background.isPresent() && drawBackground){
+ *        const Image& img = background.get(); //imageParser runs here, once
+ *    }
+ *
+ *  CommandLineParser::materializeLazyArguments converts every lazy argument at once, for programs
+ *  that want to report bad values up front after all.
+ *
+ *  A lazy argument consumes exactly one token.  Tokens that came straight from argv are recorded
+ *  as views(argv outlives the program's use of it); tokens from a response file are copied into
+ *  the handle, since the file is closed when parse returns.  Handles are registered by address,
+ *  so they can't be copied, and, like the variables passed to append*Argument, they must outlive
+ *  every parse they are used in.  Handles are not thread safe.
+ */
+class LazyArgBase{
+public:
+    explicit LazyArgBase(const ArgParser* parser);
+    virtual ~LazyArgBase(){}
+
+    /**
+     *  @return true if the last parse supplied a value for this argument.
+     */
+    inline bool isPresent()const{ return state != NOT_GIVEN; }
+
+    /**
+     *  @return the unconverted token given for this argument.  Empty if !isPresent().
+     */
+    inline std::string_view token()const{ return span; }
+
+    /**
+     *  Convert the token if that has not happened yet.
+     *  @param err describes the conversion error on failure.  The same error is returned by
+     *   every call until the next parse.
+     *  @return true if the argument was not given or was converted successfully.
+     */
+    bool materialize(std::string& err)const;
+
+    inline const ArgParser* getParser()const{ return parser; }
+
+protected:
+    /// Where the ArgParser writes the converted value.
+    virtual void* valueStorage()const = 0;
+
+    /// Called before each parse.  Restore the value the handle was created with.
+    virtual void resetValue() = 0;
+
+private:
+    friend class CommandLineParser;
+
+    LazyArgBase(const LazyArgBase&);
+    LazyArgBase& operator=(const LazyArgBase&);
+
+    enum State{NOT_GIVEN, RECORDED, CONVERTED, FAILED};
+
+    /// Forget the previous parse.
+    void reset();
+    /// Remember "tok" as the value of this argument.
+    void record(std::string_view tok);
+    /// Copy the recorded token into the handle, so it outlives the parse.
+    void pinToken();
+
+    const ArgParser* parser;
+    std::string_view span;
+    std::string ownedToken;
+    mutable State state;
+    mutable std::string error;
+};
+
+/**
+ *  A lazily converted argument of type T.  See LazyArgBase.
+ */
+template<typename T>
+class LazyArg : public LazyArgBase{
+public:
+    /**
+     *  @param parser converts the token into a T.  Typically one of the parsers in
+     *   IncludedArgParsers.h, or CommandLineParser::getCommonArgParser.
+     *  @param defaultValue is the value of the argument when it is not given.
+     */
+    explicit LazyArg(const ArgParser* parser, const T& defaultValue = T()) :
+        LazyArgBase(parser), defaultValue(defaultValue), value(defaultValue) {}
+
+    /**
+     *  The value of the argument, converting it first if necessary.  Returns the default value
+     *  when the argument was not given or could not be converted; use materialize() to tell
+     *  those apart.
+     */
+    const T& get()const{
+        std::string err;
+        if(! materialize(err)){
+            return defaultValue;
+        }
+        return value;
+    }
+
+protected:
+    virtual void* valueStorage()const{ return (void*)&value; }
+    virtual void resetValue(){ value = defaultValue; }
+
+private:
+    const T defaultValue;
+    T value;
+};
+
+#endif //LAZY_ARG_H
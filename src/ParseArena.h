@@ -0,0 +1,58 @@
+#ifndef PARSE_ARENA_H
+#define PARSE_ARENA_H
+
+#include <memory_resource>
+#include <cstddef>
+
+/**
+ *  Monotonic arena for CommandLineParser::parse.  Every transient allocation made while parsing
+ *  (the token list, the per-parse bookkeeping, response file storage) is carved out of one
+ *  buffer and nothing is freed until release() or destruction, so the whole parse is
+ *  thrown away in a single step.
+ *
+ *  A strict arena has no fallback: if the buffer is too small, allocation throws std::bad_alloc
+ *  (which parse reports as an error) instead of touching the global heap.  A non-strict arena
+ *  falls back to the default memory resource when the buffer runs out.
+ *
+ *  Example:
+ *
+ *    char buffer[16 * 1024];
+ *    ParseArena arena(buffer, sizeof(buffer));
+ *    parser.parse(argc, argv, errs, &arena);
+ *
+ *  Like std::pmr::monotonic_buffer_resource, a ParseArena is not thread safe; give each thread
+ *  its own.
+ */
+class ParseArena : public std::pmr::monotonic_buffer_resource{
+public:
+    /**
+     *  @param buffer is the memory to allocate from.  It must outlive the arena.
+     *  @param size is the size of "buffer" in bytes.
+     *  @param strict should be true to forbid falling back to the heap when "buffer" is full.
+     */
+    ParseArena(void* buffer, size_t size, bool strict = true) :
+        std::pmr::monotonic_buffer_resource(buffer, size,
+            strict ? std::pmr::null_memory_resource() : std::pmr::get_default_resource()) {}
+};
+
+/// The buffer of an InlineParseArena.  A separate base class so that it is constructed
+/// before the ParseArena that points into it.
+template<size_t N>
+struct ParseArenaStorage{
+    alignas(std::max_align_t) unsigned char storage[N];
+};
+
+/**
+ *  A ParseArena that carries its own N byte buffer.  Handy as a local variable:
+ *
+ *    InlineParseArena<16 * 1024> arena;
+ *    parser.parse(argc, argv, errs, &arena);
+ */
+template<size_t N>
+class InlineParseArena : private ParseArenaStorage<N>, public ParseArena{
+public:
+    explicit InlineParseArena(bool strict = true) :
+        ParseArenaStorage<N>(), ParseArena(this->storage, N, strict) {}
+};
+
+#endif //PARSE_ARENA_H
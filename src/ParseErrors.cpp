@@ -0,0 +1,104 @@
+#include "ParseErrors.h"
+//--
+#include "CommandLineParser.h"
+
+
+ParseErrors::ParseErrors(size_t capacity, std::pmr::memory_resource* resource) :
+    records(resource), textPool(resource), source(NULL), offset(0) {
+    records.reserve(capacity);
+}
+
+void ParseErrors::clear(){
+    records.clear();
+    textPool.clear();
+}
+
+void ParseErrors::truncate(size_t n){
+    //Their text stays in the pool; earlier records may have pinned tokens after it
+    if(n < records.size()){
+        records.erase(records.begin() + n, records.end());
+    }
+}
+
+std::string_view ParseErrors::token(size_t i)const{
+    const ParseErrorRecord& rec = records[i];
+    return std::string_view(rec.tokenPinned ? textPool.data() + rec.tokenBegin : rec.tokenData,
+        rec.tokenLength);
+}
+
+std::string_view ParseErrors::text(size_t i)const{
+    return std::string_view(textPool.data() + records[i].textBegin, records[i].textLength);
+}
+
+void ParseErrors::add(ParseErrorCode code, int argId, int tokenIndex, std::string_view token,
+    std::string_view text, int relatedArgId){
+    ParseErrorRecord rec;
+    rec.code        = code;
+    rec.argId       = argId;
+    rec.tokenIndex  = tokenIndex >= 0 ? tokenIndex + offset : tokenIndex;
+    rec.relatedArgId = relatedArgId;
+    rec.source      = source;
+    rec.tokenData   = token.data();
+    rec.tokenBegin  = 0;
+    rec.tokenLength = (uint32_t)token.size();
+    rec.textBegin   = (uint32_t)textPool.size();
+    rec.textLength  = (uint32_t)text.size();
+    rec.tokenPinned = false;
+    textPool.append(text.data(), text.size());
+    records.push_back(rec);
+}
+
+void ParseErrors::pinTokens(){
+    for(size_t i = 0; i < records.size(); i++){
+        ParseErrorRecord& rec = records[i];
+        if(! rec.tokenPinned && rec.tokenLength > 0){
+            rec.tokenBegin = (uint32_t)textPool.size();
+            textPool.append(rec.tokenData, rec.tokenLength);
+            rec.tokenData   = NULL;
+            rec.tokenPinned = true;
+        }
+    }
+}
+
+void ParseErrors::append(const ParseErrors& other){
+    const uint32_t shift = (uint32_t)textPool.size();
+    textPool += other.textPool;
+    for(size_t i = 0; i < other.records.size(); i++){
+        ParseErrorRecord rec = other.records[i];
+        rec.textBegin  += shift;
+        rec.tokenBegin += rec.tokenPinned ? shift : 0;
+        records.push_back(rec);
+    }
+}
+
+std::string ParseErrors::message(size_t i)const{
+    const ParseErrorRecord& rec = records[i];
+    const std::string tok(token(i));
+    switch(rec.code){
+        case PARSE_ERR_BAD_VALUE:
+            return "Parse error on argument: \"" + tok + "\"";
+        case PARSE_ERR_DUPLICATE:
+            return "Argument " + tok + " appeared more then once(or in an invalid manner)" +
+                "in the argument list.";
+        case PARSE_ERR_UNRECOGNIZED:
+            return "Argument " + tok + " is not recognized.";
+        case PARSE_ERR_OUT_OF_MEMORY:
+            return "Ran out of memory while parsing the command line.";
+        case PARSE_ERR_MISSING_SUBCOMMAND:
+            return "No command given(see --help for the list).";
+        case PARSE_ERR_PARSER_MESSAGE:
+        case PARSE_ERR_FALLBACK:
+        case PARSE_ERR_RESPONSE_FILE:
+            return std::string(text(i));
+        default:
+            break;
+    }
+    //The rest need the parser, for argument names
+    return rec.source != NULL ? rec.source->formatError(rec, tok) : std::string();
+}
+
+void ParseErrors::appendMessages(std::list<std::string>& errs)const{
+    for(size_t i = 0; i < records.size(); i++){
+        errs.push_back(message(i));
+    }
+}
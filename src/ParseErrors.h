@@ -0,0 +1,129 @@
+#ifndef PARSE_ERRORS_H
+#define PARSE_ERRORS_H
+
+#include <string>
+#include <string_view>
+#include <list>
+#include <vector>
+#include <memory_resource>
+#include <cstddef>
+#include <cstdint>
+
+class CommandLineParser;
+
+/**
+ *  What went wrong in a parse.
+ */
+enum ParseErrorCode{
+    PARSE_ERR_BAD_VALUE,        //The ArgParser for argId rejected token
+    PARSE_ERR_PARSER_MESSAGE,   //The ArgParser for argId failed with its own message(see text())
+    PARSE_ERR_MISSING_VALUE,    //The list argument argId was given no values
+    PARSE_ERR_DUPLICATE,        //token names an argument that was already matched(or can't go here)
+    PARSE_ERR_UNRECOGNIZED,     //token does not name any argument
+    PARSE_ERR_AMBIGUOUS,        //token abbreviates more than one argument name
+    PARSE_ERR_MISSING_REQUIRED, //The required named argument argId was not given
+    PARSE_ERR_UNMATCHED,        //The argument argId was never reached
+    PARSE_ERR_FALLBACK,         //An environment variable or the config file was bad(see text())
+    PARSE_ERR_RESPONSE_FILE,    //A response file could not be read(see text())
+    PARSE_ERR_OUT_OF_MEMORY,    //The parse's memory resource ran out
+    PARSE_ERR_MISSING_SUBCOMMAND, //The parser has subcommands, and none was given
+    PARSE_ERR_OUT_OF_RANGE,     //token converted, but is outside the range set for argId
+    PARSE_ERR_REQUIRES,         //argId was given without relatedArgId, which it requires
+    PARSE_ERR_EXCLUDES          //argId and relatedArgId were both given
+};
+
+/**
+ *  One error.  Only the fields that make sense for the code are set; the rest are -1.
+ */
+struct ParseErrorRecord{
+    ParseErrorCode code;
+    int argId;      //Index of the argument, in the order the arguments were appended
+    int tokenIndex; //Index of the offending token, counting from the first token after the
+                    //program name(after response files are expanded)
+    int relatedArgId; //The other argument of a broken dependency or exclusion
+
+private:
+    friend class ParseErrors;
+    const CommandLineParser* source; //The parser that recorded it(a subcommand's, perhaps)
+    const char* tokenData;  //Into argv, unless tokenPinned
+    uint32_t tokenBegin;    //Offset into ParseErrors::textPool, if tokenPinned
+    uint32_t tokenLength;
+    uint32_t textBegin;     //Offsets into ParseErrors::textPool
+    uint32_t textLength;
+    bool tokenPinned;
+};
+
+/**
+ *  The errors from a parse, as records rather than text.  Recording an error copies a few
+ *  words into a buffer that is reserved up front and reused across parses, so rejecting a
+ *  command line doesn't allocate(apart from errors that come with their own text, such as a
+ *  custom ArgParser's message).  The human readable message is only built when message() is
+ *  called.
+ *
+ *  The plain CommandLineParser::parse(..., std::list<std::string>& errs, ...) is a thin
+ *  adapter that calls message() for every record.
+ *
+ *  Tokens are views into argv(or into the command lines given to parseBatch), so the records
+ *  are only good for as long as those are.  Tokens that came from a response file are copied.
+ *  Messages that name an argument ask the CommandLineParser that recorded them, which must
+ *  still exist.  Errors in a subcommand's arguments are recorded by the subcommand's parser.
+ */
+class ParseErrors{
+public:
+    /**
+     *  @param capacity is the number of records to reserve room for.
+     *  @param resource is where the records and any error text are allocated.
+     */
+    explicit ParseErrors(size_t capacity = 8,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    /// Forget all errors, keeping the reserved space.
+    void clear();
+
+    inline size_t size()const{ return records.size(); }
+    inline bool empty()const{ return records.empty(); }
+    inline const ParseErrorRecord& operator[](size_t i)const{ return records[i]; }
+
+    /// The offending token of error i.  Empty if the error is not about a token.
+    std::string_view token(size_t i)const;
+
+    /// The text that came with error i(from an ArgParser, a fallback or a response file).
+    std::string_view text(size_t i)const;
+
+    /// The human readable message for error i.  Formatted on every call.
+    std::string message(size_t i)const;
+
+    /// Append the message of every error to "errs."
+    void appendMessages(std::list<std::string>& errs)const;
+
+    //Used by CommandLineParser while it parses -----------------------------
+
+    void add(ParseErrorCode code, int argId, int tokenIndex, std::string_view token,
+        std::string_view text = std::string_view(), int relatedArgId = -1);
+
+    /// Forget the errors after the first n(a parse that turned out to be asking for help).
+    void truncate(size_t n);
+
+    /// Copy every token into the ParseErrors, for when the tokens are about to go away.
+    void pinTokens();
+
+    /// Append the errors in "other."
+    void append(const ParseErrors& other);
+
+    /// Errors added from now on are recorded by "parser," and their token indices are
+    /// relative to token "tokenOffset"(where a subcommand's tokens start).
+    inline void setSource(const CommandLineParser* parser, int tokenOffset = 0){
+        source = parser;
+        offset = tokenOffset;
+    }
+    inline const CommandLineParser* getSource()const{ return source; }
+    inline int getTokenOffset()const{ return offset; }
+
+private:
+    std::pmr::vector<ParseErrorRecord> records;
+    std::pmr::string textPool;
+    const CommandLineParser* source;
+    int offset;
+};
+
+#endif //PARSE_ERRORS_H
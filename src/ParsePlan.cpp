@@ -0,0 +1,36 @@
+#include "ParsePlan.h"
+
+
+ParsePlan::ParsePlan() : lastGroup(0) {}
+
+void ParsePlan::append(void* var, const ArgParser* parser, ArgValueKind kind, uint8_t argFlags){
+    const size_t idx = vars.size();
+    vars.push_back(var);
+    parsers.push_back(parser);
+    kinds.push_back((uint8_t)kind);
+    flags.push_back(argFlags);
+    groupEnds.push_back((uint32_t)(idx + 1));
+    if(idx % 64 == 0){
+        required.push_back(0);
+    }
+    if(! ranges.empty()){
+        ranges.resize(2 * vars.size(), 0.0);
+    }
+    if(! (argFlags & PLAN_OPTIONAL)){
+        required[idx / 64] |= (uint64_t)1 << (idx % 64);
+    }
+
+    //A named argument right after another one joins its group
+    if(idx > 0 && (argFlags & PLAN_NAMED) && named(idx - 1)){
+        groupEnds[lastGroup] = (uint32_t)(idx + 1);
+    }else{
+        lastGroup = idx;
+    }
+}
+
+void ParsePlan::setRange(size_t i, double minValue, double maxValue){
+    ranges.resize(2 * vars.size(), 0.0);
+    ranges[2 * i]     = minValue;
+    ranges[2 * i + 1] = maxValue;
+    flags[i] |= PLAN_RANGE;
+}
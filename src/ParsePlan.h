@@ -0,0 +1,76 @@
+#ifndef PARSE_PLAN_H
+#define PARSE_PLAN_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+//--
+#include "ArgParser.h"
+#include "ArgValueCodec.h"
+
+/**
+ *  The part of CommandLineParser's argument list that parse() reads, laid out for the parse
+ *  loop: one dense array per field(structure of arrays) instead of a vector of structs that
+ *  also carry names and help text, plus the bounds of every group of arguments worked out in
+ *  advance.  A group is a run of adjacent named arguments, which may appear in any order, or
+ *  a single positional argument.
+ *
+ *  The plan is compiled as arguments are appended and shared, like the rest of the schema,
+ *  between copies of a CommandLineParser, so a parse never copies argument metadata.
+ */
+class ParsePlan{
+public:
+    enum Flag{
+        PLAN_NAMED    = 1 << 0,
+        PLAN_OPTIONAL = 1 << 1,
+        PLAN_LAZY     = 1 << 2, //var is a LazyArgBase*
+        PLAN_LIST     = 1 << 3, //Takes every token up to the next argument name
+        PLAN_RANGE    = 1 << 4  //Has a range(see setRange)
+    };
+
+    ParsePlan();
+
+    /// Add an argument to the end of the plan.  "flags" is a combination of Flag bits.
+    void append(void* var, const ArgParser* parser, ArgValueKind kind, uint8_t flags);
+
+    inline size_t size()const{ return vars.size(); }
+
+    inline void* var(size_t i)const{ return vars[i]; }
+    inline const ArgParser* parser(size_t i)const{ return parsers[i]; }
+    inline ArgValueKind kind(size_t i)const{ return (ArgValueKind)kinds[i]; }
+    inline bool named(size_t i)const{ return (flags[i] & PLAN_NAMED) != 0; }
+    inline bool optional(size_t i)const{ return (flags[i] & PLAN_OPTIONAL) != 0; }
+    inline bool lazy(size_t i)const{ return (flags[i] & PLAN_LAZY) != 0; }
+    inline bool list(size_t i)const{ return (flags[i] & PLAN_LIST) != 0; }
+
+    /**
+     *  @param groupBegin is the first argument of a group: 0, or the groupEnd of the group
+     *   before it.
+     *  @return one past the last argument of the group.
+     */
+    inline size_t groupEnd(size_t groupBegin)const{ return groupEnds[groupBegin]; }
+
+    /**
+     *  One bit per argument, set for the required ones, 64 to a word.  Lets the check for
+     *  missing arguments go a word at a time.
+     */
+    inline const uint64_t* requiredWords()const{ return required.data(); }
+
+    /// Values of argument i must be in [minValue, maxValue].  Only for the numeric kinds.
+    void setRange(size_t i, double minValue, double maxValue);
+    inline bool hasRange(size_t i)const{ return (flags[i] & PLAN_RANGE) != 0; }
+    inline double rangeMin(size_t i)const{ return ranges[2 * i]; }
+    inline double rangeMax(size_t i)const{ return ranges[2 * i + 1]; }
+
+private:
+    std::vector<void*> vars;
+    std::vector<const ArgParser*> parsers;
+    std::vector<uint8_t> kinds;
+    std::vector<uint8_t> flags;
+    std::vector<uint32_t> groupEnds; //Only meaningful at the first argument of each group
+    std::vector<uint64_t> required;
+    std::vector<double> ranges;      //Min and max per argument, once any argument has a range
+    size_t lastGroup;                //First argument of the last group
+};
+
+#endif //PARSE_PLAN_H
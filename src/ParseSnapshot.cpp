@@ -0,0 +1,138 @@
+#include "ParseSnapshot.h"
+//--
+#include <cstring>
+
+//Bump whenever the snapshot layout changes
+static const uint32_t SNAPSHOT_VERSION = 1;
+static const char SNAPSHOT_MAGIC[8] = {'C', 'L', 'P', 'S', 'N', 'A', 'P', '\0'};
+
+//Everything at the start of a snapshot.  The records follow.
+struct SnapshotHeader{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder; //0x01020304 as written
+    uint64_t fingerprint;
+    uint64_t recordsSize;
+};
+
+//Each record starts with {uint8 kind, uint32 index, uint32 payload size}
+static const size_t RECORD_HEADER_SIZE = 9;
+
+
+static void appendU32(std::string& out, uint32_t x){
+    out.append((const char*)&x, sizeof(x));
+}
+
+static uint32_t readU32(const char* p){
+    uint32_t x;
+    memcpy(&x, p, sizeof(x));
+    return x;
+}
+
+
+ParseSnapshot::ParseSnapshot(uint64_t fingerprint) : fingerprint(fingerprint) {}
+
+void ParseSnapshot::beginRecord(RecordKind kind, size_t index, size_t payloadSize){
+    blob += (char)kind;
+    appendU32(blob, (uint32_t)index);
+    appendU32(blob, (uint32_t)payloadSize);
+}
+
+void ParseSnapshot::addValue(size_t arg, ArgValueKind kind, const void* var){
+    //The size is only known once the value is encoded, so patch it in afterwards
+    beginRecord(RECORD_VALUE, arg, 0);
+    const size_t start = blob.size();
+    encodeArgVariable(kind, var, blob);
+    const uint32_t size = (uint32_t)(blob.size() - start);
+    memcpy(&blob[start - sizeof(size)], &size, sizeof(size));
+}
+
+void ParseSnapshot::addTokens(size_t arg, const std::string_view* begin,
+    const std::string_view* end){
+    size_t size = 0;
+    for(const std::string_view* it = begin; it != end; it++){
+        size += sizeof(uint32_t) + it->size();
+    }
+    beginRecord(RECORD_TOKENS, arg, size);
+    for(const std::string_view* it = begin; it != end; it++){
+        appendU32(blob, (uint32_t)it->size());
+        blob.append(it->data(), it->size());
+    }
+}
+
+void ParseSnapshot::addFlag(std::string_view tok){
+    beginRecord(RECORD_FLAG, 0, tok.size());
+    blob.append(tok.data(), tok.size());
+}
+
+void ParseSnapshot::addSubcommand(size_t verb, uint64_t subFingerprint){
+    beginRecord(RECORD_SUBCOMMAND, verb, sizeof(subFingerprint));
+    blob.append((const char*)&subFingerprint, sizeof(subFingerprint));
+}
+
+std::string ParseSnapshot::bytes()const{
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version     = SNAPSHOT_VERSION;
+    header.byteOrder   = 0x01020304;
+    header.fingerprint = fingerprint;
+    header.recordsSize = blob.size();
+    std::string out((const char*)&header, sizeof(header));
+    out += blob;
+    return out;
+}
+
+bool ParseSnapshot::readHeader(std::string_view bytes, uint64_t& fingerprint,
+    std::string_view& records){
+    if(bytes.size() < sizeof(SnapshotHeader)){
+        return false;
+    }
+    SnapshotHeader header;
+    memcpy(&header, bytes.data(), sizeof(header));
+    if(memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+        header.version != SNAPSHOT_VERSION || header.byteOrder != 0x01020304 ||
+        header.recordsSize != bytes.size() - sizeof(header)){
+        return false;
+    }
+    fingerprint = header.fingerprint;
+    records     = bytes.substr(sizeof(header));
+    return true;
+}
+
+bool ParseSnapshot::nextRecord(std::string_view& records, Record& rec){
+    if(records.size() < RECORD_HEADER_SIZE){
+        return false;
+    }
+    const uint8_t kind = (uint8_t)records[0];
+    const uint32_t size = readU32(records.data() + 5);
+    if(kind > RECORD_SUBCOMMAND || size > records.size() - RECORD_HEADER_SIZE){
+        return false;
+    }
+    rec.kind    = (RecordKind)kind;
+    rec.index   = readU32(records.data() + 1);
+    rec.payload = records.substr(RECORD_HEADER_SIZE, size);
+    records.remove_prefix(RECORD_HEADER_SIZE + size);
+    return true;
+}
+
+bool ParseSnapshot::nextToken(std::string_view& payload, std::string_view& tok){
+    if(payload.size() < sizeof(uint32_t)){
+        return false;
+    }
+    const uint32_t size = readU32(payload.data());
+    if(size > payload.size() - sizeof(uint32_t)){
+        return false;
+    }
+    tok = payload.substr(sizeof(uint32_t), size);
+    payload.remove_prefix(sizeof(uint32_t) + size);
+    return true;
+}
+
+uint64_t ParseSnapshot::subcommandFingerprint(std::string_view payload){
+    uint64_t x = 0;
+    if(payload.size() == sizeof(x)){
+        memcpy(&x, payload.data(), sizeof(x));
+    }
+    return x;
+}
@@ -0,0 +1,104 @@
+#ifndef PARSE_SNAPSHOT_H
+#define PARSE_SNAPSHOT_H
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+//--
+#include "ArgValueCodec.h"
+
+/**
+ *  The binary form of a successful parse, so that a process started with the same command
+ *  line as another one can fill its variables without tokenizing and converting it all again.
+ *  See CommandLineParser::writeSnapshot.
+ *
+ *  A snapshot is a header(which carries the fingerprint of the argument list it was written
+ *  for) followed by one record per argument that was given, in the order they were matched:
+ *    -RECORD_VALUE: the binary form of a common kind(see ArgValueCodec.h), written straight
+ *     into the variable.
+ *    -RECORD_TOKENS: the tokens given for an argument with no binary form(custom, list and
+ *     lazy arguments).  They are run through the argument's ArgParser again.
+ *    -RECORD_FLAG: a flag token, applied again as is.
+ *    -RECORD_SUBCOMMAND: the verb that was selected, and the fingerprint of its parser.  The
+ *     records after it belong to the verb's parser.
+ *
+ *  Snapshots are only read by the build that wrote them: integers are in native byte order,
+ *  and a snapshot from another byte order is rejected.
+ */
+class ParseSnapshot{
+public:
+    enum RecordKind{
+        RECORD_VALUE      = 0,
+        RECORD_TOKENS     = 1,
+        RECORD_FLAG       = 2,
+        RECORD_SUBCOMMAND = 3
+    };
+
+    /// One record, as read back.  payload points into the snapshot.
+    struct Record{
+        RecordKind kind;
+        uint32_t index; //The argument(or verb) the record is for.  Unused for RECORD_FLAG.
+        std::string_view payload;
+    };
+
+    /**
+     *  Start an empty snapshot.
+     *  @param fingerprint is CommandLineParser::schemaFingerprint of the writing parser.
+     */
+    explicit ParseSnapshot(uint64_t fingerprint = 0);
+
+    //Writing ---------------------------------------------------------------
+
+    /// Record the value of argument "arg," a common kind, from its variable.
+    void addValue(size_t arg, ArgValueKind kind, const void* var);
+
+    /// Record the tokens [begin, end) given for argument "arg."
+    void addTokens(size_t arg, const std::string_view* begin, const std::string_view* end);
+
+    /// Record a flag token.
+    void addFlag(std::string_view tok);
+
+    /// Record that verb "verb" was selected.  fingerprint is that of the verb's parser.
+    void addSubcommand(size_t verb, uint64_t fingerprint);
+
+    /**
+     *  @return the snapshot: the header, then every record added so far.
+     */
+    std::string bytes()const;
+
+    //Reading ---------------------------------------------------------------
+
+    /**
+     *  Check the header of a snapshot.
+     *  @param bytes is the whole snapshot.
+     *  @param fingerprint receives the fingerprint it was written with.
+     *  @param records receives the records that follow the header.
+     *  @return false if "bytes" is not a snapshot from this build.
+     */
+    static bool readHeader(std::string_view bytes, uint64_t& fingerprint, std::string_view& records);
+
+    /**
+     *  Take the first record off "records."
+     *  @return false if "records" is empty or the record is cut short(check records.empty()
+     *   to tell them apart).
+     */
+    static bool nextRecord(std::string_view& records, Record& rec);
+
+    /**
+     *  Take the first token off the payload of a RECORD_TOKENS record.
+     *  @return false if "payload" is empty or the token is cut short.
+     */
+    static bool nextToken(std::string_view& payload, std::string_view& tok);
+
+    /// The fingerprint stored in a RECORD_SUBCOMMAND payload.  0 if the payload is malformed.
+    static uint64_t subcommandFingerprint(std::string_view payload);
+
+private:
+    uint64_t fingerprint;
+    std::string blob; //The records
+
+    void beginRecord(RecordKind kind, size_t index, size_t payloadSize);
+};
+
+#endif //PARSE_SNAPSHOT_H
@@ -0,0 +1,94 @@
+#include "ParseStats.h"
+
+
+ParseStats::ParseStats() : heapAllocationCounter(NULL) {
+    clear();
+}
+
+void ParseStats::clear(){
+    parses = 0;
+    resourceAllocations = 0;
+    for(int i = 0; i < NUM_PHASES; i++){
+        phases[i].calls = phases[i].nanoseconds = phases[i].allocations = 0;
+    }
+    for(size_t i = 0; i < args.size(); i++){
+        args[i].calls = args[i].nanoseconds = args[i].allocations = 0;
+    }
+}
+
+const char* ParseStats::phaseName(Phase phase){
+    switch(phase){
+        case PHASE_ARGV_COPY      : return "argv_copy";
+        case PHASE_HELP_SCAN      : return "help_scan";
+        case PHASE_POSITIONAL     : return "positional";
+        case PHASE_NAMED          : return "named";
+        case PHASE_REQUIRED_CHECK : return "required_check";
+        default                   : return "unknown";
+    }
+}
+
+ParseStats::Mark ParseStats::mark()const{
+    Mark m;
+    m.allocations = resourceAllocations +
+        (heapAllocationCounter != NULL ? heapAllocationCounter->load(std::memory_order_relaxed) : 0);
+    m.time = std::chrono::steady_clock::now(); //Last, so it doesn't time the allocation count
+    return m;
+}
+
+void ParseStats::add(Cost& cost, const Mark& since)const{
+    const Mark now = mark();
+    cost.calls       += 1;
+    cost.nanoseconds += (unsigned long long)
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now.time - since.time).count();
+    cost.allocations += now.allocations - since.allocations;
+}
+
+/// Write "str" as a JSON string.
+static void printJsonString(std::ostream& os, const std::string& str){
+    os << '"';
+    for(size_t i = 0; i < str.size(); i++){
+        const char c = str[i];
+        if(c == '"' || c == '\\'){
+            os << '\\';
+        }
+        os << c;
+    }
+    os << '"';
+}
+
+static void printJsonCost(std::ostream& os, const ParseStats::Cost& cost){
+    os << "\"calls\": " << cost.calls << ", \"ns\": " << cost.nanoseconds <<
+        ", \"allocs\": " << cost.allocations;
+}
+
+void ParseStats::printJson(std::ostream& os)const{
+    os << "{\n  \"parses\": " << parses << ",\n  \"phases\": {\n";
+    for(int i = 0; i < NUM_PHASES; i++){
+        os << "    \"" << phaseName((Phase)i) << "\": {";
+        printJsonCost(os, phases[i]);
+        os << (i + 1 < NUM_PHASES ? "},\n" : "}\n");
+    }
+    os << "  },\n  \"args\": [\n";
+    for(size_t i = 0; i < args.size(); i++){
+        os << "    {\"name\": ";
+        printJsonString(os, args[i].name);
+        os << ", ";
+        printJsonCost(os, args[i]);
+        os << (i + 1 < args.size() ? "},\n" : "}\n");
+    }
+    os << "  ]\n}\n";
+}
+
+void* ParseStats::CountingResource::do_allocate(size_t bytes, size_t alignment){
+    void* p = upstream->allocate(bytes, alignment);
+    ++stats->resourceAllocations;
+    return p;
+}
+
+void ParseStats::CountingResource::do_deallocate(void* p, size_t bytes, size_t alignment){
+    upstream->deallocate(p, bytes, alignment);
+}
+
+bool ParseStats::CountingResource::do_is_equal(const std::pmr::memory_resource& other)const noexcept{
+    return this == &other;
+}
@@ -0,0 +1,126 @@
+#ifndef PARSE_STATS_H
+#define PARSE_STATS_H
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory_resource>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ *  Where CommandLineParser::parse spends its time and allocations.  Build with the
+ *  CMD_PARSE_STATS preprocessor flag(the CMake option of the same name) and hand a ParseStats
+ *  to CommandLineParser::setParseStats; every following parse adds to it.  Without the flag
+ *  the parse path contains no instrumentation at all and the ParseStats stays empty.
+ *
+ *  Allocations are those made through the parse's std::pmr::memory_resource.  Allocations
+ *  made directly on the global heap(by ArgParsers, for example) are counted too if
+ *  heapAllocationCounter points at a counter that the program's operator new increments.
+ *
+ *  Phases are nested the way parse runs them, so PHASE_NAMED includes the ArgParser calls for
+ *  named arguments; "args" breaks the ArgParser calls down per argument.
+ */
+struct ParseStats{
+    enum Phase{
+        PHASE_ARGV_COPY,      //Building the token list from argv(and any response files)
+        PHASE_HELP_SCAN,      //Looking for --help and friends
+        PHASE_POSITIONAL,     //Matching and parsing positional arguments
+        PHASE_NAMED,          //Matching and parsing runs of named arguments
+        PHASE_REQUIRED_CHECK, //Fallbacks and the check for missing required arguments
+        NUM_PHASES
+    };
+
+    struct Cost{
+        unsigned long long calls;
+        unsigned long long nanoseconds;
+        unsigned long long allocations;
+    };
+
+    /// Cost of the ArgParser calls for one argument.
+    struct ArgCost : public Cost{
+        std::string name;
+    };
+
+    unsigned long long parses;
+    Cost phases[NUM_PHASES];
+    std::vector<ArgCost> args; //One entry per argument, in the order they were appended
+
+    /// Optional counter of global heap allocations, maintained by the program.
+    const std::atomic<unsigned long long>* heapAllocationCounter;
+    /// Allocations made through the parse's memory resource so far.
+    unsigned long long resourceAllocations;
+
+    ParseStats();
+
+    /// Reset every count to zero.
+    void clear();
+
+    /// Name of a phase, as used in the JSON output.
+    static const char* phaseName(Phase phase);
+
+    /// Write everything as a JSON object.
+    void printJson(std::ostream& os = std::cout)const;
+
+    //Used by CommandLineParser while it parses -----------------------------
+
+    /// A point in time, and in the allocation count.
+    struct Mark{
+        std::chrono::steady_clock::time_point time;
+        unsigned long long allocations;
+    };
+    Mark mark()const;
+    void add(Cost& cost, const Mark& since)const;
+
+    /// Counts allocations made through the parse's memory resource.
+    class CountingResource : public std::pmr::memory_resource{
+    public:
+        CountingResource(std::pmr::memory_resource* upstream, ParseStats* stats) :
+            upstream(upstream), stats(stats) {}
+    private:
+        std::pmr::memory_resource* upstream;
+        ParseStats* stats;
+        virtual void* do_allocate(size_t bytes, size_t alignment);
+        virtual void do_deallocate(void* p, size_t bytes, size_t alignment);
+        virtual bool do_is_equal(const std::pmr::memory_resource& other)const noexcept;
+    };
+
+    /// Adds the time and allocations from construction to end()(or destruction) to one Cost.
+    class Scope{
+    public:
+        Scope(const ParseStats* stats, Cost* cost) : stats(stats), cost(cost) {
+            if(stats != NULL){
+                start = stats->mark();
+            }
+        }
+        ~Scope(){ end(); }
+        void end(){
+            if(stats != NULL){
+                stats->add(*cost, start);
+                stats = NULL;
+            }
+        }
+    private:
+        const ParseStats* stats;
+        Cost* cost;
+        Mark start;
+    };
+};
+
+//Instrumentation points in CommandLineParser.cpp.  They expand to nothing unless
+//CMD_PARSE_STATS is defined.
+#ifdef CMD_PARSE_STATS
+#define PARSE_STATS_PHASE(scope, stats, phase) \
+    ParseStats::Scope scope(stats, (stats) != NULL ? &(stats)->phases[ParseStats::phase] : NULL)
+#define PARSE_STATS_ARG(scope, stats, argIdx) \
+    ParseStats::Scope scope(stats, (stats) != NULL ? &(stats)->args[argIdx] : NULL)
+#define PARSE_STATS_END(scope) scope.end()
+#else
+#define PARSE_STATS_PHASE(scope, stats, phase)
+#define PARSE_STATS_ARG(scope, stats, argIdx)
+#define PARSE_STATS_END(scope)
+#endif
+
+#endif //PARSE_STATS_H
@@ -0,0 +1,230 @@
+#include "ResponseFile.h"
+//--
+#include <cstring>
+#include <cerrno>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <functional>
+#include <algorithm>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define RESPONSE_FILE_USE_MMAP 1
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+//Files smaller than this are always tokenized on the calling thread
+static const size_t PARALLEL_MIN_BYTES = 1 << 20;
+
+//Each thread gets at least this much of the file
+static const size_t MIN_CHUNK_BYTES = 256 << 10;
+
+
+/// Remove shell quoting from one entry, writing the result to "ret."
+/// See ResponseFile::tokenize for the rules.
+static void unquoteEntry(std::string_view entry, std::pmr::string& ret){
+    ret.reserve(entry.size());
+    char quote = 0; //The quote character we are inside of, or 0
+    for(size_t i = 0; i < entry.size(); i++){
+        const char c = entry[i];
+        if(quote == '\''){
+            if(c == '\''){
+                quote = 0;
+            }else{
+                ret += c;
+            }
+        }else if(quote == '"'){
+            if(c == '"'){
+                quote = 0;
+            }else if(c == '\\' && i + 1 < entry.size() &&
+                (entry[i+1] == '"' || entry[i+1] == '\\' || entry[i+1] == '$' || entry[i+1] == '`')){
+                ret += entry[++i];
+            }else{
+                ret += c;
+            }
+        }else if(c == '\'' || c == '"'){
+            quote = c;
+        }else if(c == '\\' && i + 1 < entry.size()){
+            ret += entry[++i];
+        }else{
+            ret += c;
+        }
+    }
+}
+
+void tokenizeResponseBuffer(const char* buffer, size_t len, char delim, bool shellQuoted,
+    std::pmr::vector<std::string_view>& tokens, std::pmr::deque<std::pmr::string>& storage){
+
+    const char* curr = buffer;
+    const char* const end = buffer + len;
+    while(curr < end){
+        const char* stop = (const char*)memchr(curr, delim, (size_t)(end - curr));
+        if(stop == NULL){
+            stop = end;
+        }
+        std::string_view entry(curr, (size_t)(stop - curr));
+        if(delim == '\n' && ! entry.empty() && entry.back() == '\r'){
+            entry.remove_suffix(1);
+        }
+        if(! entry.empty()){
+            if(shellQuoted && entry.find_first_of("'\"\\") != std::string_view::npos){
+                storage.emplace_back();
+                unquoteEntry(entry, storage.back());
+                tokens.push_back(storage.back());
+            }else{
+                tokens.push_back(entry);
+            }
+        }
+        curr = stop + 1;
+    }
+}
+
+
+ResponseFile::ResponseFile(std::pmr::memory_resource* resource) : data(NULL), length(0),
+    mapped(false), readBuffer(resource), unquoted(resource) {}
+
+ResponseFile::~ResponseFile(){
+    unmap();
+}
+
+void ResponseFile::unmap(){
+#ifdef RESPONSE_FILE_USE_MMAP
+    if(mapped){
+        munmap((void*)data, length);
+    }
+#endif
+    data   = NULL;
+    length = 0;
+    mapped = false;
+    readBuffer.clear();
+    unquoted.clear();
+}
+
+bool ResponseFile::open(std::string_view pathView, std::string& err){
+    unmap();
+    const std::pmr::string path(pathView, readBuffer.get_allocator()); //NUL terminated
+
+#ifdef RESPONSE_FILE_USE_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0){
+        err = "Could not open response file " + std::string(pathView) + ": " + strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode)){
+        length = (size_t)st.st_size;
+        if(length == 0){
+            ::close(fd);
+            return true;
+        }
+        void* addr = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(addr != MAP_FAILED){
+            madvise(addr, length, MADV_SEQUENTIAL);
+            ::close(fd);
+            data   = (const char*)addr;
+            mapped = true;
+            return true;
+        }
+        length = 0;
+    }
+
+    //Not a regular file, or mmap failed.  Read it instead.
+    char buf[1 << 16];
+    ssize_t n;
+    while((n = ::read(fd, buf, sizeof(buf))) > 0){
+        readBuffer.append(buf, (size_t)n);
+    }
+    const int readErr = errno;
+    ::close(fd);
+    if(n < 0){
+        readBuffer.clear();
+        err = "Could not read response file " + std::string(pathView) + ": " + strerror(readErr);
+        return false;
+    }
+#else
+    std::ifstream in(path.c_str(), std::ios::in | std::ios::binary);
+    if(! in){
+        err = "Could not open response file " + std::string(pathView);
+        return false;
+    }
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    const std::string str = contents.str();
+    readBuffer.assign(str.data(), str.size());
+#endif
+
+    data   = readBuffer.data();
+    length = readBuffer.size();
+    return true;
+}
+
+void ResponseFile::tokenize(std::pmr::vector<std::string_view>& tokens, bool shellQuoted, unsigned numThreads){
+    if(length == 0){
+        return;
+    }
+    const char delim = memchr(data, '\0', length) != NULL ? '\0' : '\n';
+
+    if(numThreads == 0){
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    numThreads = (unsigned)std::min<size_t>(numThreads, length / MIN_CHUNK_BYTES);
+    if(length < PARALLEL_MIN_BYTES || numThreads <= 1){
+        tokenizeResponseBuffer(data, length, delim, shellQuoted, tokens, unquoted);
+        return;
+    }
+
+    //Split the file into roughly equal chunks, moving each boundary forward to just past
+    //the next delimiter so that no entry is split between two chunks.
+    std::vector<size_t> bounds(1, 0);
+    for(unsigned i = 1; i < numThreads; i++){
+        size_t pos = std::max(bounds.back(), (length / numThreads) * i);
+        const char* stop = (const char*)memchr(data + pos, delim, length - pos);
+        pos = stop == NULL ? length : (size_t)(stop - data) + 1;
+        if(pos >= length){
+            break;
+        }
+        bounds.push_back(pos);
+    }
+    bounds.push_back(length);
+    const size_t numChunks = bounds.size() - 1;
+
+    //Per chunk scratch space comes from the(thread safe) global heap
+    std::pmr::memory_resource* heap = std::pmr::new_delete_resource();
+    std::vector<std::pmr::vector<std::string_view> > chunkTokens;
+    std::vector<std::pmr::deque<std::pmr::string> > chunkStorage;
+    for(size_t i = 0; i < numChunks; i++){
+        chunkTokens.emplace_back(heap);
+        chunkStorage.emplace_back(heap);
+    }
+    std::vector<std::thread> pool;
+    for(size_t i = 1; i < numChunks; i++){
+        pool.push_back(std::thread(tokenizeResponseBuffer, data + bounds[i], bounds[i+1] - bounds[i],
+            delim, shellQuoted, std::ref(chunkTokens[i]), std::ref(chunkStorage[i])));
+    }
+    tokenizeResponseBuffer(data, bounds[1], delim, shellQuoted, chunkTokens[0], chunkStorage[0]);
+    for(size_t i = 0; i < pool.size(); i++){
+        pool[i].join();
+    }
+
+    size_t total = tokens.size();
+    for(size_t i = 0; i < numChunks; i++){
+        total += chunkTokens[i].size();
+    }
+    tokens.reserve(total);
+    for(size_t i = 0; i < numChunks; i++){
+        for(size_t j = 0; j < chunkTokens[i].size(); j++){
+            const std::string_view tok = chunkTokens[i][j];
+            if(tok.data() >= data && tok.data() < data + length){
+                tokens.push_back(tok);
+            }else{
+                //An unquoted entry; move it out of the chunk's scratch space
+                unquoted.emplace_back(tok);
+                tokens.push_back(unquoted.back());
+            }
+        }
+    }
+}
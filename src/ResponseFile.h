@@ -0,0 +1,83 @@
+#ifndef RESPONSE_FILE_H
+#define RESPONSE_FILE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <memory_resource>
+#include <cstddef>
+
+/**
+ *  A read-only, memory-mapped "@file" of command line arguments.  Passing arguments in a
+ *  file gets around the operating system's limit on the size of argv(ARG_MAX).
+ *
+ *  The file holds one argument per entry.  If it contains a NUL byte, entries are NUL
+ *  separated(as written by "find -print0"); otherwise they are newline separated, and a
+ *  trailing carriage return is dropped.  Empty entries are skipped.
+ *
+ *  Tokens are std::string_views directly into the mapping, so a file of several million
+ *  paths is tokenized without copying any of them.  The only exception is shell-quoted
+ *  entries(see tokenize()), which are unquoted into storage owned by the ResponseFile.
+ *  Large files are split into chunks at entry boundaries and tokenized on several threads.
+ *
+ *  Tokens are only valid for as long as the ResponseFile that produced them exists.
+ *
+ *  Everything a ResponseFile allocates(the unquoted entries, and the file contents when it
+ *  can't be mapped) comes from the std::pmr::memory_resource it was created with.
+ */
+class ResponseFile{
+public:
+    explicit ResponseFile(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    ~ResponseFile();
+
+    /**
+     *  Map a file.  Files that can't be mapped(pipes, for example) are read into memory instead.
+     *  @param path is the path of the file.
+     *  @param err describes what went wrong on failure.
+     *  @return true on success, false on failure.
+     */
+    bool open(std::string_view path, std::string& err);
+
+    /**
+     *  Append the entries of the file to "tokens."
+     *  @param tokens receives the entries, in file order.
+     *  @param shellQuoted should be true to remove shell quoting from each entry:
+     *   '...' is taken literally, "..." honors the escapes \" \\ \$ and \`, and a backslash
+     *   outside of quotes escapes the next character.  Entries are still separated only by
+     *   newlines(or NULs), so whitespace inside an entry never needs quoting.
+     *  @param numThreads is the maximum number of threads to use.  0 means one per hardware thread.
+     *   Small files are always tokenized on the calling thread.  When more than one thread is
+     *   used, the scratch space for each chunk comes from the global heap, since most memory
+     *   resources(std::pmr::monotonic_buffer_resource, for example) are not thread safe.
+     */
+    void tokenize(std::pmr::vector<std::string_view>& tokens, bool shellQuoted, unsigned numThreads = 0);
+
+    inline size_t size()const{ return length; }
+
+    /// The bytes of the file, as mapped(or read).
+    inline std::string_view contents()const{ return std::string_view(data, length); }
+
+private:
+    //Not copyable; the tokens point into the mapping
+    ResponseFile(const ResponseFile&);
+    ResponseFile& operator=(const ResponseFile&);
+
+    const char* data;
+    size_t length;
+    bool mapped;
+    std::pmr::string readBuffer;             //File contents, when the file could not be mapped
+    std::pmr::deque<std::pmr::string> unquoted; //Shell-quoted entries.  A deque never moves its
+                                                //elements, so tokens can point into them.
+
+    void unmap();
+};
+
+/**
+ *  Tokenize the entries of buffer[0, len), separated by "delim."  Chunks of a large file are
+ *  passed through here one at a time.  Entries that need unquoting are stored in "storage."
+ */
+void tokenizeResponseBuffer(const char* buffer, size_t len, char delim, bool shellQuoted,
+    std::pmr::vector<std::string_view>& tokens, std::pmr::deque<std::pmr::string>& storage);
+
+#endif //RESPONSE_FILE_H
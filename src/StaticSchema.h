@@ -0,0 +1,279 @@
+#ifndef STATIC_SCHEMA_H
+#define STATIC_SCHEMA_H
+
+#include <string>
+#include <string_view>
+#include <list>
+#include <array>
+#include <bitset>
+#include <tuple>
+#include <utility>
+#include <iostream>
+#include <cstddef>
+#include <cstdint>
+//--
+#include "CommandLineParser.h"
+#include "IncludedArgParsers.h"
+#include "ArgNameTable.h"
+#include "ArgUsage.h"
+
+
+/**
+ *  Compile-time alternative to CommandLineParser for binaries whose argument list never changes.
+ *
+ *  Arguments are declared once, as a constexpr list:
+ *
+ *    static constexpr auto schema = makeStaticSchema("Print a word.",
+ *        staticPositionalArg<int>("-word_count", "Number of times to print the word."),
+ *        staticNamedArg<std::string>("-word", true, "What word to print?"));
+ *    static_assert(schema.isValid(), "bad argument names");
+ *    ...
+ *    int count = 0;
+ *    std::string word("cat");
+ *    schema.parse(argc, argv, errs, std::cout, &count, &word);
+ *
+ *  The compiler builds the name->slot dispatch table and the usage table, and instantiates one
+ *  conversion per argument type(ArgValueTraits<T>::fromString), so nothing is registered at
+ *  startup and no virtual ArgParser::parseArg call is made.  The matching rules(positional arguments, runs of adjacent named
+ *  arguments, required/optional) are the same as CommandLineParser::parse.  Every argument consumes
+ *  exactly one token; arguments that need a custom multi-token ArgParser should use
+ *  CommandLineParser instead.
+ */
+
+/**
+ *  One argument of a StaticSchema.  T is the type of the variable the argument is parsed into.
+ *  Create these with staticPositionalArg and staticNamedArg.
+ */
+template<typename T>
+struct StaticArg{
+    typedef T ValueType;
+    std::string_view name;
+    std::string_view helpTxt;
+    bool optional;
+    bool named;
+};
+
+/**
+ *  Declare a positional argument.  All positional arguments are required.
+ */
+template<typename T>
+constexpr StaticArg<T> staticPositionalArg(std::string_view argName, std::string_view helpStr = ""){
+    return StaticArg<T>{argName, helpStr, false, false};
+}
+
+/**
+ *  Declare a named argument.  By default, named arguments are optional.
+ */
+template<typename T>
+constexpr StaticArg<T> staticNamedArg(std::string_view argName, bool optional = true,
+    std::string_view helpStr = ""){
+    return StaticArg<T>{argName, helpStr, optional, true};
+}
+
+
+template<typename... Ts>
+class StaticSchema{
+public:
+    static constexpr size_t NUM_ARGS = sizeof...(Ts);
+
+    constexpr StaticSchema(std::string_view helpMessage, const StaticArg<Ts>&... args) :
+        helpMsg(helpMessage), usage{ArgUsage{args.name, args.helpTxt, args.optional, args.named}...},
+        sortedHashes(), sortedSlots(), groupEnds()
+    {
+        //Dispatch table: slots sorted by the hash of their name(insertion sort, it's compile time)
+        for(size_t i = 0; i < NUM_ARGS; i++){
+            const uint64_t h = ArgNameTable::hash(usage[i].name);
+            size_t j = i;
+            while(j > 0 && sortedHashes[j - 1] > h){
+                sortedHashes[j] = sortedHashes[j - 1];
+                sortedSlots[j]  = sortedSlots[j - 1];
+                --j;
+            }
+            sortedHashes[j] = h;
+            sortedSlots[j]  = i;
+        }
+
+        //For each named argument, one past the end of its run of adjacent named arguments
+        for(size_t i = NUM_ARGS; i > 0; i--){
+            const size_t idx = i - 1;
+            groupEnds[idx] = (idx + 1 < NUM_ARGS && usage[idx + 1].named) ? groupEnds[idx + 1] : idx + 1;
+        }
+    }
+
+    /**
+     *  Same rules as CommandLineParser::isArgumentNameOK, applied to every argument:
+     *  names are unique, contain only printable non-whitespace ASCII, and are not one of the
+     *  "--help" keywords(unless there is no help message).  Use this in a static_assert.
+     */
+    constexpr bool isValid()const{
+        for(size_t i = 0; i < NUM_ARGS; i++){
+            if(! isValidArgString(usage[i].name) || (! helpMsg.empty() && isHelpStr(usage[i].name))){
+                return false;
+            }
+            if(usage[i].optional && ! usage[i].named){
+                return false;
+            }
+            if(findSlot(usage[i].name) != (int)i){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     *  @return the index of the argument called "name," or -1 if there is none.
+     */
+    constexpr int findSlot(std::string_view name)const{
+        const uint64_t h = ArgNameTable::hash(name);
+        size_t lo = 0, hi = NUM_ARGS;
+        while(lo < hi){
+            const size_t mid = lo + (hi - lo) / 2;
+            if(sortedHashes[mid] < h){
+                lo = mid + 1;
+            }else{
+                hi = mid;
+            }
+        }
+        for(; lo < NUM_ARGS && sortedHashes[lo] == h; lo++){
+            if(usage[sortedSlots[lo]].name == name){
+                return (int)sortedSlots[lo];
+            }
+        }
+        return -1;
+    }
+
+    /**
+     *  Parse a command line into the given variables, one per argument, in declaration order.
+     *  Errors and the return value are the same as for CommandLineParser::parse.  A help message
+     *  is printed on "outStream."
+     */
+    CommandLineParser::ParseDoneStatus parse(int argc, char** argv, std::list<std::string>& errs,
+        std::ostream& outStream, Ts*... targets)const{
+        return parseImpl(argc, argv, errs, outStream, std::tuple<Ts*...>(targets...),
+            std::index_sequence_for<Ts...>());
+    }
+
+    /**
+     *  Print the applications help message.
+     *  @param appName is the name of the binary.  Should usually be argv[0].
+     *  @param os is the stream to print on.  Defaults to std::cout.
+     */
+    void printHelpMessage(std::string_view appName, std::ostream& os = std::cout)const{
+        printUsageMessage(os, appName, helpMsg, usage.data(), NUM_ARGS);
+    }
+
+private:
+    std::string_view helpMsg;
+    std::array<ArgUsage, NUM_ARGS> usage;
+    std::array<uint64_t, NUM_ARGS> sortedHashes;
+    std::array<size_t,   NUM_ARGS> sortedSlots;
+    std::array<size_t,   NUM_ARGS> groupEnds;
+
+    /// Convert "tok" into the variable for "slot."  The fold expands to a switch over the slots,
+    /// each case calling the converter for that slot's type directly.
+    template<size_t... Is>
+    static bool convertSlot(size_t slot, std::string_view tok, const std::tuple<Ts*...>& targets,
+        std::index_sequence<Is...>){
+        bool ok = false;
+        (void)((slot == Is ? (ok = ArgValueTraits<Ts>::fromString(tok, *std::get<Is>(targets)), true) : false) || ...);
+        return ok;
+    }
+
+    template<size_t... Is>
+    CommandLineParser::ParseDoneStatus parseImpl(int argc, char** argv, std::list<std::string>& errs,
+        std::ostream& os, const std::tuple<Ts*...>& targets, std::index_sequence<Is...> seq)const{
+
+        //First check if we should print the help message and be done
+        for(int i = 1; i < argc; i++){
+            if(isHelpStr(argv[i])){
+                printHelpMessage(argc > 0 ? argv[0] : "", os);
+                return CommandLineParser::HELP_PRINTED;
+            }
+        }
+
+        std::bitset<NUM_ARGS> consumed;
+        size_t nextArg = 0;
+        int pos = 1; //This is 1(not 0) to skip the program name
+        while(pos < argc){
+
+            if(nextArg == NUM_ARGS){
+                //This indicates that some argument(s) are not matched with anything
+                for(; pos < argc; pos++){
+                    const std::string tok(argv[pos]);
+                    if(findSlot(tok) >= 0){
+                        errs.push_back("Argument " + tok +
+                            " appeared more then once(or in an invalid manner)" +
+                            "in the argument list.");
+                    }else{
+                        errs.push_back("Argument " + tok + " is not recognized.");
+                    }
+                }
+                return CommandLineParser::ERROR;
+            }
+
+            if(! usage[nextArg].named){ //A single positional argument
+                if(! convertSlot(nextArg, argv[pos], targets, seq)){
+                    errs.push_back("Parse error on argument: \"" + std::string(argv[pos]) + "\"");
+                    return CommandLineParser::ERROR;
+                }
+                consumed.set(nextArg);
+                ++nextArg;
+                ++pos;
+
+            }else{ //A run of 1 or more named arguments
+                const size_t groupBegin = nextArg;
+                const size_t groupEnd = groupEnds[nextArg];
+                nextArg = groupEnd;
+
+                while(argc - pos >= 2){
+                    const int slot = findSlot(argv[pos]);
+                    if(slot < (int)groupBegin || slot >= (int)groupEnd || consumed.test(slot)){
+                        break;
+                    }
+                    if(! convertSlot(slot, argv[pos + 1], targets, seq)){
+                        errs.push_back("Parse error on argument: \"" + std::string(argv[pos + 1]) + "\"");
+                        return CommandLineParser::ERROR;
+                    }
+                    consumed.set(slot);
+                    pos += 2;
+                }
+
+                //Make sure that the only named arguments left are optional
+                bool missedAtLeastOneArg = false;
+                for(size_t i = groupBegin; i < groupEnd; i++){
+                    if(! consumed.test(i) && ! usage[i].optional){
+                        errs.push_back("No value specified for required named argument " +
+                            std::string(usage[i].name));
+                        missedAtLeastOneArg = true;
+                    }
+                }
+                if(missedAtLeastOneArg){
+                    return CommandLineParser::ERROR;
+                }
+            }
+        }
+
+        //Make sure we matched all the non-named arguments
+        bool noErr = true;
+        for(size_t i = nextArg; i < NUM_ARGS; i++){
+            if(! usage[i].optional){
+                noErr = false;
+                std::string tstr = usage[i].named ? "named" : "positional";
+                errs.push_back("Did not match " + tstr + " argument: " + std::string(usage[i].name));
+            }
+        }
+        return noErr ? CommandLineParser::SUCCESS : CommandLineParser::ERROR;
+    }
+};
+
+/**
+ *  Build a StaticSchema.  Intended to be used in a constexpr variable declaration.
+ *  @param helpMessage is the application's help text.  May be empty.
+ *  @param args are the arguments, in order, created with staticPositionalArg and staticNamedArg.
+ */
+template<typename... Ts>
+constexpr StaticSchema<Ts...> makeStaticSchema(std::string_view helpMessage, const StaticArg<Ts>&... args){
+    return StaticSchema<Ts...>(helpMessage, args...);
+}
+
+#endif //STATIC_SCHEMA_H
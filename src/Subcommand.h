@@ -0,0 +1,42 @@
+#ifndef SUBCOMMAND_H
+#define SUBCOMMAND_H
+
+class CommandLineParser;
+
+/**
+ *  Builds the parser for one subcommand("verb") of a git style tool:
+ *
+ *    tool [global options] <verb> [options of the verb]
+ *
+ *  Register one factory per verb with CommandLineParser::appendSubcommand.  A verb's parser is
+ *  only built, by calling buildParser, the first time argv selects that verb, so a tool with
+ *  hundreds of verbs pays for the one it runs.  The help message lists the verbs without
+ *  building any of them.
+ *
+ *  Factories usually own the variables their arguments write to:
+ *
+ *    class CloneCommand : public SubcommandFactory{
+ *    public:
+ *        std::string url;
+ *        int depth = 0;
+ *        virtual void buildParser(CommandLineParser& parser){
+ *            parser.appendPositionalArgument(&url, "url", "Repository to clone.");
+ *            parser.appendNamedArgument(&depth, "-depth", true, "History to fetch.");
+ *        }
+ *    };
+ *
+ *  Factories must outlive the CommandLineParser they are registered with.
+ */
+class SubcommandFactory{
+public:
+    virtual ~SubcommandFactory(){}
+
+    /**
+     *  Append the arguments of the verb to "parser."  Called at most once, the first time
+     *  the verb is parsed(from whichever thread gets there first); the parser is frozen
+     *  afterwards.  The parser's help message is the help text given to appendSubcommand.
+     */
+    virtual void buildParser(CommandLineParser& parser) = 0;
+};
+
+#endif //SUBCOMMAND_H
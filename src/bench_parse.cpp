@@ -0,0 +1,472 @@
+//Benchmarks for CommandLineParser::parse and the parsers in IncludedArgParsers.h.
+//
+//Build and run with "make bench".  Every benchmark reports the time and the number of
+//global heap allocations per token(or per call, for the micro benchmarks), so regressions in
+//the hot path show up as either getting slower or allocating more.  Pass a benchmark name
+//prefix as the first argument to run a subset, e.g. "bin/bench_parse micro".  In a build
+//configured with -DCMD_PARSE_STATS=ON, "bin/bench_parse stats" prints a ParseStats breakdown.
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <list>
+#include <chrono>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <new>
+//--
+#include "CommandLineParser.h"
+#include "IncludedArgParsers.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BENCH_HAVE_GETOPT 1
+#include <getopt.h>
+#endif
+
+
+//Allocation counting ---------------------------------------------------------
+static std::atomic<unsigned long long> g_numAllocs(0);
+
+void* operator new(size_t size){
+    ++g_numAllocs;
+    void* p = malloc(size == 0 ? 1 : size);
+    if(p == NULL){
+        throw std::bad_alloc();
+    }
+    return p;
+}
+void* operator new[](size_t size){ return operator new(size); }
+void operator delete(void* p)noexcept{ free(p); }
+void operator delete[](void* p)noexcept{ free(p); }
+void operator delete(void* p, size_t)noexcept{ free(p); }
+void operator delete[](void* p, size_t)noexcept{ free(p); }
+
+
+//Harness ---------------------------------------------------------------------
+static std::string g_filter;
+
+/// Keep the optimizer from discarding a result.
+template<typename T>
+static inline void doNotOptimize(const T& value){
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/// Run "func" repeatedly for at least MIN_SECONDS and print the cost per unit of work.
+/// Each call to func does "unitsPerCall" units(tokens, or calls for micro benchmarks).
+template<typename Func>
+static void runBench(const std::string& name, const std::string& unit, size_t unitsPerCall, Func func){
+    if(name.compare(0, g_filter.size(), g_filter) != 0){
+        return;
+    }
+    typedef std::chrono::steady_clock Clock;
+    const double MIN_SECONDS = 0.2;
+
+    func(); //Warm up
+    unsigned long long iters = 0;
+    const unsigned long long allocsBefore = g_numAllocs;
+    const Clock::time_point start = Clock::now();
+    double elapsed = 0.0;
+    do{
+        for(int i = 0; i < 16; i++){
+            func();
+        }
+        iters += 16;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    }while(elapsed < MIN_SECONDS);
+    const unsigned long long allocs = g_numAllocs - allocsBefore;
+
+    const double units = (double)iters * (double)(unitsPerCall == 0 ? 1 : unitsPerCall);
+    std::cout << std::left << std::setw(44) << name << std::right <<
+        std::setw(12) << std::fixed << std::setprecision(2) << (elapsed * 1e9 / units) << " ns/" << unit <<
+        std::setw(12) << std::setprecision(3) << ((double)allocs / units) << " allocs/" << unit << std::endl;
+}
+
+/// A command line, with the char** view that parse expects.  Like the argv a program is
+/// started with, the strings lie back to back in one buffer, each followed by its '\0'.
+struct BenchArgv{
+    std::vector<std::string> strs;
+    std::string packed;
+    std::vector<char*> ptrs;
+
+    void push(const std::string& s){ strs.push_back(s); }
+    void finish(){
+        packed.clear();
+        for(size_t i = 0; i < strs.size(); i++){
+            packed += strs[i];
+            packed += '\0';
+        }
+        ptrs.clear();
+        size_t at = 0;
+        for(size_t i = 0; i < strs.size(); i++){
+            ptrs.push_back(&packed[at]);
+            at += strs[i].size() + 1;
+        }
+        ptrs.push_back(NULL);
+    }
+    int argc()const{ return (int)strs.size(); }
+    char** argv(){ return ptrs.data(); }
+};
+
+static std::string optName(size_t i){
+    std::ostringstream ss;
+    ss << "--option-" << i;
+    return ss.str();
+}
+
+
+//Parse benchmarks ------------------------------------------------------------
+
+/// numOptions named options are registered, and numGiven of them are supplied.
+/// String values if useStrings, otherwise ints.
+static void benchNamed(size_t numOptions, size_t numGiven, bool useStrings){
+    CommandLineParser parser("bench");
+    std::vector<int> ints(numOptions);
+    std::vector<std::string> strs(numOptions);
+    for(size_t i = 0; i < numOptions; i++){
+        if(useStrings){
+            parser.appendNamedArgument(&strs[i], optName(i),
+                parser.getCommonArgParser(CommandLineParser::AP_STRING));
+        }else{
+            parser.appendNamedArgument(&ints[i], optName(i),
+                parser.getCommonArgParser(CommandLineParser::AP_INT));
+        }
+    }
+
+    //Spread the supplied options over the registered ones.  Each option may only be given
+    //once(duplicates are an error), so skip any index that comes up twice.
+    BenchArgv args;
+    args.push("bench");
+    std::vector<bool> seen(numOptions, false);
+    for(size_t i = 0; i < numGiven; i++){
+        const size_t idx = (i * 7919) % numOptions;
+        if(! seen[idx]){
+            seen[idx] = true;
+            args.push(optName(idx));
+            args.push(useStrings ? std::string("/some/fairly/long/path/name") : std::string("123456"));
+        }
+    }
+    args.finish();
+
+    std::ostringstream name;
+    name << "parse/named/" << (useStrings ? "string" : "int") << "/options=" << numOptions <<
+        "/tokens=" << (args.argc() - 1);
+    std::list<std::string> errs;
+    runBench(name.str(), "token", (size_t)(args.argc() - 1), [&](){
+        errs.clear();
+        CommandLineParser::ParseDoneStatus st = parser.parse(args.argc(), args.argv(), errs, std::cout);
+        doNotOptimize(st);
+    });
+}
+
+/// Alternating positional and named arguments: pos0 --named0 v pos1 --named1 v ...
+static void benchMixed(size_t numPairs){
+    CommandLineParser parser("bench");
+    std::vector<double> pos(numPairs);
+    std::vector<int> named(numPairs);
+    BenchArgv args;
+    args.push("bench");
+    for(size_t i = 0; i < numPairs; i++){
+        std::ostringstream pname;
+        pname << "pos" << i;
+        parser.appendPositionalArgument(&pos[i], pname.str(),
+            parser.getCommonArgParser(CommandLineParser::AP_DOUBLE));
+        parser.appendNamedArgument(&named[i], optName(i),
+            parser.getCommonArgParser(CommandLineParser::AP_INT));
+        args.push("3.14159");
+        args.push(optName(i));
+        args.push("42");
+    }
+    args.finish();
+
+    std::ostringstream name;
+    name << "parse/mixed/pairs=" << numPairs;
+    std::list<std::string> errs;
+    runBench(name.str(), "token", (size_t)(args.argc() - 1), [&](){
+        errs.clear();
+        CommandLineParser::ParseDoneStatus st = parser.parse(args.argc(), args.argv(), errs, std::cout);
+        doNotOptimize(st);
+    });
+}
+
+/// One named list argument with numValues int values: --values 0 1 2 ...
+static void benchList(size_t numValues){
+    CommandLineParser parser("bench");
+    std::vector<int> values;
+    parser.appendNamedListArgument(&values, "--values");
+    BenchArgv args;
+    args.push("bench");
+    args.push("--values");
+    for(size_t i = 0; i < numValues; i++){
+        std::ostringstream ss;
+        ss << i;
+        args.push(ss.str());
+    }
+    args.finish();
+
+    std::ostringstream name;
+    name << "parse/list/int/tokens=" << (args.argc() - 1);
+    std::list<std::string> errs;
+    runBench(name.str(), "token", (size_t)(args.argc() - 1), [&](){
+        errs.clear();
+        CommandLineParser::ParseDoneStatus st = parser.parse(args.argc(), args.argv(), errs, std::cout);
+        doNotOptimize(st);
+    });
+}
+
+/// One comma separated token of "numValues" floats, through DelimitedListArgParser.
+static void benchDelimited(size_t numValues){
+    CommandLineParser parser("bench");
+    std::vector<float> values;
+    parser.appendNamedArgument(&values, "--weights");
+    std::ostringstream list;
+    for(size_t i = 0; i < numValues; i++){
+        list << (i > 0 ? "," : "") << (float)i * 0.001f;
+    }
+    BenchArgv args;
+    args.push("bench");
+    args.push("--weights");
+    args.push(list.str());
+    args.finish();
+
+    std::ostringstream name;
+    name << "parse/delimited/float/elements=" << numValues;
+    std::list<std::string> errs;
+    runBench(name.str(), "element", numValues, [&](){
+        errs.clear();
+        CommandLineParser::ParseDoneStatus st = parser.parse(args.argc(), args.argv(), errs, std::cout);
+        doNotOptimize(st);
+    });
+}
+
+/// numOptions named options(half ints, half strings), all given, loaded from a snapshot
+/// written by the same parser instead of being parsed.  Compare with parse/named.
+static void benchSnapshot(size_t numOptions){
+    CommandLineParser parser("bench");
+    std::vector<int> ints(numOptions);
+    std::vector<std::string> strs(numOptions);
+    BenchArgv args;
+    args.push("bench");
+    for(size_t i = 0; i < numOptions; i++){
+        if(i % 2 == 0){
+            parser.appendNamedArgument(&ints[i], optName(i));
+            args.push(optName(i));
+            args.push("123456");
+        }else{
+            parser.appendNamedArgument(&strs[i], optName(i));
+            args.push(optName(i));
+            args.push("/some/fairly/long/path/name");
+        }
+    }
+    args.finish();
+    parser.setSnapshotOption("--from-snapshot");
+
+    const std::string path = "bench_parse.snapshot";
+    std::string snapshot;
+    std::list<std::string> errs;
+    parser.writeSnapshot(args.argc(), args.argv(), snapshot, errs, std::cout);
+    FILE* f = fopen(path.c_str(), "wb");
+    if(f == NULL){
+        return;
+    }
+    fwrite(snapshot.data(), 1, snapshot.size(), f);
+    fclose(f);
+
+    BenchArgv loadArgs;
+    loadArgs.push("bench");
+    loadArgs.push("--from-snapshot");
+    loadArgs.push(path);
+    loadArgs.finish();
+
+    std::ostringstream name;
+    name << "parse/snapshot/options=" << numOptions << "/tokens=" << (args.argc() - 1);
+    runBench(name.str(), "token", (size_t)(args.argc() - 1), [&](){
+        errs.clear();
+        CommandLineParser::ParseDoneStatus st = parser.parse(loadArgs.argc(), loadArgs.argv(), errs,
+            std::cout);
+        doNotOptimize(st);
+    });
+    remove(path.c_str());
+}
+
+#ifdef BENCH_HAVE_GETOPT
+/// Baseline: the same workload as benchNamed(int values) through getopt_long and strtol.
+static void benchGetoptLong(size_t numOptions, size_t numGiven){
+    std::vector<std::string> names(numOptions);
+    std::vector<struct option> opts(numOptions + 1);
+    for(size_t i = 0; i < numOptions; i++){
+        names[i] = optName(i).substr(2); //getopt_long wants the name without "--"
+        opts[i].name    = names[i].c_str();
+        opts[i].has_arg = required_argument;
+        opts[i].flag    = NULL;
+        opts[i].val     = 0;
+    }
+    memset(&opts[numOptions], 0, sizeof(struct option));
+
+    BenchArgv args;
+    args.push("bench");
+    std::vector<bool> seen(numOptions, false);
+    for(size_t i = 0; i < numGiven; i++){
+        const size_t idx = (i * 7919) % numOptions;
+        if(! seen[idx]){
+            seen[idx] = true;
+            args.push(optName(idx));
+            args.push("123456");
+        }
+    }
+    args.finish();
+    std::vector<int> ints(numOptions);
+    std::vector<char*> argvCopy;
+
+    std::ostringstream name;
+    name << "getopt_long/named/int/options=" << numOptions << "/tokens=" << (args.argc() - 1);
+    runBench(name.str(), "token", (size_t)(args.argc() - 1), [&](){
+        argvCopy = args.ptrs; //getopt_long may permute argv
+        optind = 0;           //Fully reinitialize getopt(GNU extension)
+        opterr = 0;
+        int longIndex = 0;
+        while(getopt_long(args.argc(), argvCopy.data(), "", opts.data(), &longIndex) == 0){
+            ints[longIndex] = (int)strtol(optarg, NULL, 10);
+        }
+        doNotOptimize(ints[0]);
+    });
+}
+#endif
+
+
+//Micro benchmarks ------------------------------------------------------------
+
+/// Time parser.parseArg on a single token.
+static void benchArgParser(const std::string& name, const ArgParser& parser, void* result,
+    const std::string& token){
+    const std::string_view view(token);
+    std::string err;
+    runBench("micro/ArgParser/" + name, "call", 1, [&](){
+        ArgCursor cursor(&view, &view + 1);
+        const bool ok = parser.parseArg(cursor, result, err);
+        doNotOptimize(ok);
+    });
+}
+
+static void benchMicro(){
+    float f; double d; int i; unsigned int u; std::string s; bool b; long l;
+    benchArgParser("FloatArgParser",       FloatArgParser(),       &f, "3.1415927");
+    benchArgParser("DoubleArgParser",      DoubleArgParser(),      &d, "2.718281828459045");
+    benchArgParser("IntArgParser",         IntArgParser(),         &i, "-123456");
+    benchArgParser("UnsignedIntArgParser", UnsignedIntArgParser(), &u, "4000000000");
+    benchArgParser("StringArgParser",      StringArgParser(),      &s, "/some/fairly/long/path/name");
+    benchArgParser("BoolArgParser",        BoolArgParser(),        &b, "false");
+    benchArgParser("GenericParser<long>",  GenericParser<long>(),  &l, "9876543210");
+
+    //A parser with a realistic number of arguments for the name and help benchmarks
+    CommandLineParser parser("bench", "A program with many options.");
+    std::vector<int> ints(200);
+    for(size_t k = 0; k < ints.size(); k++){
+        parser.appendNamedArgument(&ints[k], optName(k),
+            parser.getCommonArgParser(CommandLineParser::AP_INT), true, "Some option.");
+    }
+    const std::string freshName("--a-fresh-option-name");
+    runBench("micro/isArgumentNameOK/options=200", "call", 1, [&](){
+        const bool ok = parser.isArgumentNameOK(freshName);
+        doNotOptimize(ok);
+    });
+
+    std::ostringstream sink;
+    runBench("micro/printHelpMessage/options=200", "call", 1, [&](){
+        sink.str("");
+        parser.printHelpMessage("bench", sink);
+    });
+
+    //Completing "--option-1" matches 111 of the 200 names; "--option-19" matches 1
+    const std::string_view manyWords[] = {"--option-5", "1", "--option-1"};
+    runBench("micro/printCompletions/matches=111", "call", 1, [&](){
+        sink.str("");
+        parser.printCompletions(manyWords, 3, sink);
+    });
+    const std::string_view oneWord[] = {"--option-19"};
+    runBench("micro/printCompletions/matches=1", "call", 1, [&](){
+        sink.str("");
+        parser.printCompletions(oneWord, 1, sink);
+    });
+}
+
+
+#ifdef CMD_PARSE_STATS
+/// "bin/bench_parse stats": the per-phase breakdown of a mixed command line, as JSON.
+static void printParseStats(){
+    CommandLineParser parser("bench");
+    std::vector<double> pos(64);
+    std::vector<int> named(64);
+    BenchArgv args;
+    args.push("bench");
+    for(size_t i = 0; i < pos.size(); i++){
+        std::ostringstream pname;
+        pname << "pos" << i;
+        parser.appendPositionalArgument(&pos[i], pname.str(),
+            parser.getCommonArgParser(CommandLineParser::AP_DOUBLE));
+        parser.appendNamedArgument(&named[i], optName(i),
+            parser.getCommonArgParser(CommandLineParser::AP_INT));
+        args.push("3.14159");
+        args.push(optName(i));
+        args.push("42");
+    }
+    args.finish();
+
+    ParseStats stats;
+    stats.heapAllocationCounter = &g_numAllocs;
+    parser.setParseStats(&stats);
+    std::list<std::string> errs;
+    for(int i = 0; i < 1000; i++){
+        errs.clear();
+        parser.parse(args.argc(), args.argv(), errs, std::cout);
+    }
+    stats.printJson(std::cout);
+}
+#endif
+
+int main(int argc, char** argv){
+    if(argc > 1){
+        g_filter = argv[1];
+    }
+#ifdef CMD_PARSE_STATS
+    if(g_filter == "stats"){
+        printParseStats();
+        return 0;
+    }
+#endif
+
+    //Scale the number of tokens with a fixed schema
+    const size_t givenCounts[] = {1, 16, 256, 4096};
+    for(size_t i = 0; i < sizeof(givenCounts) / sizeof(givenCounts[0]); i++){
+        benchNamed(4096, givenCounts[i], false);
+    }
+    //Scale the number of registered options with a fixed number of tokens
+    const size_t optionCounts[] = {16, 256, 1536, 8192};
+    for(size_t i = 0; i < sizeof(optionCounts) / sizeof(optionCounts[0]); i++){
+        benchNamed(optionCounts[i], 16, false);
+        benchNamed(optionCounts[i], 16, true);
+    }
+    benchMixed(16);
+    benchMixed(1024);
+    benchList(16);
+    benchList(100000);
+    benchDelimited(16);
+    benchDelimited(1000000);
+    benchSnapshot(16);
+    benchSnapshot(4096);
+
+#ifdef BENCH_HAVE_GETOPT
+    for(size_t i = 0; i < sizeof(givenCounts) / sizeof(givenCounts[0]); i++){
+        benchGetoptLong(4096, givenCounts[i]);
+    }
+    for(size_t i = 0; i < sizeof(optionCounts) / sizeof(optionCounts[0]); i++){
+        benchGetoptLong(optionCounts[i], 16);
+    }
+#endif
+
+    benchMicro();
+    return 0;
+}
@@ -0,0 +1,55 @@
+#include <iostream>
+#include <string>
+#include <list>
+//--
+#include "StaticSchema.h"
+
+
+//Same program as example_simple.cpp, but with the argument list fixed at compile time.
+//Nothing is registered at startup; the compiler builds the lookup tables.
+static constexpr auto SCHEMA = makeStaticSchema(
+    "Print a word a specified number of times.  The word defaults to \"cat,\" but can be changed.",
+    staticPositionalArg<int>("-word_count", "Number of times to print the specified word."),
+    staticNamedArg<bool>("-reverse", true, //true here indicates an optional argument
+        "Should we reverse the word before printing?  Use \"true\" or \"false\"."),
+    staticNamedArg<std::string>("-word", true, "What word to print?  Any string is OK."));
+
+//This fails to compile if we had an argument name with a space, or an
+//argument name that was used multiple times.
+static_assert(SCHEMA.isValid(), "Invalid argument list.");
+
+
+int main(int argc, char** argv){
+
+    //Declare all of the variables we wish to get from our command line arguments
+    int word_count = 0;
+    bool reverse   = false;
+    std::string word("cat");
+
+    //Parse the input arguments to this program.  The variables are given in the same
+    //order as the arguments in SCHEMA.
+    std::list<std::string> errsRet;
+    CommandLineParser::ParseDoneStatus status =
+        SCHEMA.parse(argc, argv, errsRet, std::cout, &word_count, &reverse, &word);
+
+    //See how things went
+    if(status == CommandLineParser::HELP_PRINTED){
+        return 0;
+    }else if(status == CommandLineParser::ERROR){
+        std::cerr << "Encountered one or more errors when parsing" <<
+            " command line arguments:" << std::endl;
+        for(std::list<std::string>::iterator itr = errsRet.begin();
+            itr != errsRet.end(); itr++){
+            std::cerr << "\t" << *itr << std::endl;
+        }
+        return 1;
+    }else{
+        if(reverse){
+            word = std::string(word.rbegin(), word.rend());
+        }
+        for(int i = 0; i < word_count; i++){
+            std::cout << word << std::endl;
+        }
+        return 0;
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <initializer_list>
+
+/**
+ *  Just enough of a test framework for the tests in this directory, which all build into
+ *  bin/run_tests.  "bin/run_tests batch" runs every test of the group "batch"; with no argument
+ *  every test runs.  The exit status is the number of failed checks(0 on success).
+ *
+ *  TEST_CASE(group, name){ ... } defines and registers a test.  CHECK(cond) reports a failure
+ *  and keeps going; unlike assert, it is not compiled out of release builds.
+ */
+struct TestCase{
+    std::string group;
+    std::string name;
+    void (*func)();
+};
+
+std::vector<TestCase>& testRegistry();
+int& testFailures();
+
+struct TestRegistrar{
+    TestRegistrar(const char* group, const char* name, void (*func)()){
+        TestCase test;
+        test.group = group;
+        test.name  = name;
+        test.func  = func;
+        testRegistry().push_back(test);
+    }
+};
+
+#define TEST_CASE(group, name) \
+    static void group##_##name(); \
+    static TestRegistrar group##_##name##Registrar(#group, #name, group##_##name); \
+    static void group##_##name()
+
+#define CHECK(cond) \
+    do{ \
+        if(!(cond)){ \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond ") failed" << std::endl; \
+            ++testFailures(); \
+        } \
+    }while(0)
+
+/// Copies a list of arguments into an argv style array of char*.
+class TestArgv{
+public:
+    TestArgv(std::initializer_list<std::string> args) : strs(args){
+        for(size_t i = 0; i < strs.size(); i++){
+            ptrs.push_back(&strs[i][0]);
+        }
+        ptrs.push_back(NULL);
+    }
+    int argc()const{ return (int)strs.size(); }
+    char** argv(){ return ptrs.data(); }
+
+private:
+    std::vector<std::string> strs;
+    std::vector<char*> ptrs;
+};
+
+#endif //TEST_H
@@ -0,0 +1,33 @@
+#include "Test.h"
+
+
+std::vector<TestCase>& testRegistry(){
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+int& testFailures(){
+    static int failures = 0;
+    return failures;
+}
+
+int main(int argc, char** argv){
+    const std::string group = argc > 1 ? argv[1] : "";
+    size_t numRun = 0;
+    for(size_t i = 0; i < testRegistry().size(); i++){
+        const TestCase& test = testRegistry()[i];
+        if(! group.empty() && test.group != group){
+            continue;
+        }
+        const int before = testFailures();
+        test.func();
+        std::cout << (testFailures() == before ? "PASS " : "FAIL ") << test.group << "/" <<
+            test.name << std::endl;
+        ++numRun;
+    }
+    if(numRun == 0){
+        std::cerr << "No tests in group \"" << group << "\"" << std::endl;
+        return 1;
+    }
+    return testFailures();
+}
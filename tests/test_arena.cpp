@@ -0,0 +1,97 @@
+//Tests for parsing into a ParseArena.  The global operator new is replaced with one that
+//counts, which every other test in the runner goes through too; counting doesn't change them.
+
+#include "Test.h"
+//--
+#include <atomic>
+#include <cstdlib>
+#include <new>
+//--
+#include "CommandLineParser.h"
+#include "ParseArena.h"
+#include "ParseErrors.h"
+
+static std::atomic<size_t> numGlobalAllocs(0);
+
+void* operator new(size_t size){
+    ++numGlobalAllocs;
+    void* p = std::malloc(size ? size : 1);
+    if(p == NULL){
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t size){
+    return operator new(size);
+}
+
+void operator delete(void* p)noexcept{
+    std::free(p);
+}
+
+void operator delete[](void* p)noexcept{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t)noexcept{
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t)noexcept{
+    std::free(p);
+}
+
+TEST_CASE(arena, successfulParseDoesNotTouchTheHeap){
+    CommandLineParser parser("app", "Arena test.");
+    int count = 0;
+    double d = 0;
+    unsigned u = 0;
+    bool b = false;
+    float f = 0;
+    int verbose = 0, version = 0;
+    parser.appendPositionalArgument(&count, "count");
+    parser.appendNamedArgument(&d, "-d");
+    parser.appendNamedArgument(&u, "-u");
+    parser.appendNamedArgument(&b, "-b");
+    parser.appendNamedArgument(&f, "-f");
+    parser.appendNamedArgument(&verbose, "--verbose");
+    parser.appendNamedArgument(&version, "--version");
+    parser.setAbbreviationsAllowed(true);
+
+    //"--verb" is an abbreviation, which is looked up in the name trie
+    TestArgv args{"app", "7", "-d", "0.25", "-u", "12", "-b", "true", "--verb", "3"};
+    ParseErrors errors;
+    InlineParseArena<64 * 1024> arena;
+
+    //The first parse may set up statics(locale, the schema's lookup tables); only count the second
+    CHECK(parser.parse(args.argc(), args.argv(), errors, &arena) == CommandLineParser::SUCCESS);
+    arena.release();
+    count = 0;
+
+    const size_t before = numGlobalAllocs;
+    const CommandLineParser::ParseDoneStatus status =
+        parser.parse(args.argc(), args.argv(), errors, &arena);
+    const size_t numAllocs = numGlobalAllocs - before;
+
+    CHECK(before != 0); //Building the parser allocated, so the counting operator new is in use
+    CHECK(status == CommandLineParser::SUCCESS);
+    CHECK(errors.size() == 0);
+    CHECK(numAllocs == 0);
+    CHECK(count == 7 && d == 0.25 && u == 12 && b && f == 0 && verbose == 3 && version == 0);
+}
+
+TEST_CASE(arena, tooSmallStrictArenaIsAnError){
+    CommandLineParser parser("app", "Arena test.");
+    int count = 0;
+    double d = 0;
+    parser.appendPositionalArgument(&count, "count");
+    parser.appendNamedArgument(&d, "-d");
+
+    //Three tokens need more than 16 bytes of views
+    TestArgv args{"app", "7", "-d", "0.5"};
+    ParseErrors errors;
+    InlineParseArena<16> arena;
+    CHECK(parser.parse(args.argc(), args.argv(), errors, &arena) == CommandLineParser::ERROR);
+    CHECK(errors.size() != 0);
+}
@@ -0,0 +1,84 @@
+//Tests for the ArgParser base class.
+
+#include "Test.h"
+//--
+#include "ArgParser.h"
+#include "IncludedArgParsers.h"
+
+/// Overrides neither parseArg, which compiles since both have defaults.
+class NeitherParser : public ArgParser{};
+
+/// Overrides only the original list interface.
+class ListOnlyParser : public ArgParser{
+public:
+    using ArgParser::parseArg;
+    virtual bool parseArg(std::list<std::string>& args, void* placeResultHere, std::string& err)const{
+        if(args.empty()){
+            err = "Nothing to parse";
+            return false;
+        }
+        *(std::string*)placeResultHere = args.front() + "!";
+        args.pop_front();
+        return true;
+    }
+};
+
+/// A list-only parser that delegates to another parser's ArgCursor version.
+class DelegatingParser : public ArgParser{
+public:
+    using ArgParser::parseArg;
+    virtual bool parseArg(std::list<std::string>& args, void* placeResultHere, std::string& err)const{
+        std::vector<std::string_view> views(args.begin(), args.end());
+        ArgCursor cursor(views.data(), views.data() + views.size());
+        const bool ret = inner.parseArg(cursor, placeResultHere, err);
+        if(ret){
+            args.pop_front();
+        }
+        return ret;
+    }
+    ListOnlyParser inner;
+};
+
+TEST_CASE(argparser, neitherOverloadFailsInsteadOfRecursing){
+    NeitherParser parser;
+    std::string_view toks[] = {"a"};
+    ArgCursor cursor(toks, toks + 1);
+    std::string err;
+    int value = 0;
+    CHECK(! parser.parseArg(cursor, &value, err));
+    CHECK(err == "ArgParser implements neither parseArg overload.");
+
+    std::list<std::string> list(1, "a");
+    err.clear();
+    CHECK(! parser.parseArg(list, &value, err));
+    CHECK(! err.empty());
+
+    //The guard is per call; the next call fails the same way
+    err.clear();
+    CHECK(! parser.parseArg(cursor, &value, err) && ! err.empty());
+}
+
+TEST_CASE(argparser, listOnlyParserWorksThroughTheCursor){
+    ListOnlyParser parser;
+    std::string_view toks[] = {"a", "b"};
+    ArgCursor cursor(toks, toks + 2);
+    std::string err, value;
+    CHECK(parser.parseArg(cursor, &value, err));
+    CHECK(value == "a!" && cursor.size() == 1);
+
+    DelegatingParser delegating;
+    ArgCursor cursor2(toks + 1, toks + 2);
+    CHECK(delegating.parseArg(cursor2, &value, err));
+    CHECK(value == "b!" && cursor2.empty());
+}
+
+TEST_CASE(argparser, cursorOnlyParserWorksThroughTheList){
+    IntArgParser parser;
+    std::list<std::string> list;
+    list.push_back("12");
+    list.push_back("rest");
+    std::string err;
+    int value = 0;
+    CHECK(parser.parseArg(list, &value, err));
+    CHECK(value == 12 && list.size() == 1);
+}
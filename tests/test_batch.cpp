@@ -0,0 +1,137 @@
+//Tests for CommandLineParser::parseBatch, run on several threads at once.
+
+#include "Test.h"
+//--
+#include <atomic>
+#include <thread>
+//--
+#include "CommandLineParser.h"
+#include "IncludedArgParsers.h"
+
+/// Only overrides parseArg, so it gets the default(locking, writing) validateArg.
+class LegacyIntParser : public ArgParser{
+public:
+    using ArgParser::parseArg;
+    virtual bool parseArg(ArgCursor& args, void* placeResultHere, std::string& err)const{
+        int value = 0;
+        if(args.empty() || ! convertFromStringToT<int>(args.front(), value)){
+            err = "Not an int";
+            return false;
+        }
+        args.popFront();
+        *(int*)placeResultHere = value;
+        return true;
+    }
+};
+
+/// Overrides validateArg, and counts the calls to make sure parseBatch uses it.
+class CheckedIntParser : public LegacyIntParser{
+public:
+    CheckedIntParser() : numValidated(0) {}
+    virtual bool validateArg(ArgCursor& args, void* /*placeResultHere*/, std::string& err)const{
+        ++numValidated;
+        int tmp;
+        return parseArg(args, &tmp, err);
+    }
+    mutable std::atomic<size_t> numValidated;
+};
+
+static std::vector<std::vector<std::string> > makeLines(size_t numLines){
+    std::vector<std::vector<std::string> > lines;
+    for(size_t i = 0; i < numLines; i++){
+        const std::string n = std::to_string(i);
+        switch(i % 4){
+            case 0: //Good
+                lines.push_back({"app", n, "-d", "0.5", "-s", "text", "-b", "true", "-c", n, "-l", n});
+                break;
+            case 1: //Bad built-in value
+                lines.push_back({"app", n, "-d", "x" + n});
+                break;
+            case 2: //Bad custom value
+                lines.push_back({"app", n, "-c", "y" + n});
+                break;
+            default: //Bad legacy value
+                lines.push_back({"app", n, "-l", "z" + n});
+                break;
+        }
+    }
+    return lines;
+}
+
+TEST_CASE(batch, concurrentLinesGetTheirOwnResults){
+    CommandLineParser parser("app", "Batch test.");
+    int count = -1;
+    double d = -1;
+    std::string s = "untouched";
+    bool b = false;
+    int custom = -1, legacy = -1;
+    CheckedIntParser checked;
+    LegacyIntParser legacyParser;
+    parser.appendPositionalArgument(&count, "count");
+    parser.appendNamedArgument(&d, "-d");
+    parser.appendNamedArgument(&s, "-s");
+    parser.appendNamedArgument(&b, "-b");
+    parser.appendNamedArgument(&custom, "-c", &checked);
+    parser.appendNamedArgument(&legacy, "-l", &legacyParser);
+
+    const std::vector<std::vector<std::string> > lines = makeLines(20000);
+    for(unsigned numThreads = 1; numThreads <= 8; numThreads *= 2){
+        std::vector<CommandLineParser::BatchResult> results;
+        std::vector<std::string> errors;
+        parser.parseBatch(lines, results, errors, numThreads);
+        CHECK(results.size() == lines.size());
+        size_t numBad = 0;
+        for(size_t i = 0; i < lines.size(); i++){
+            const CommandLineParser::BatchResult& res = results[i];
+            if(i % 4 == 0){
+                numBad += res.status != CommandLineParser::SUCCESS || res.numErrors != 0;
+                continue;
+            }
+            const std::string& tok = lines[i].back();
+            numBad += res.status != CommandLineParser::ERROR || res.numErrors != 1;
+            if(res.numErrors == 1 && i % 4 == 1){
+                numBad += errors[res.firstError] != "Parse error on argument: \"" + tok + "\"";
+            }else if(res.numErrors == 1){
+                numBad += errors[res.firstError] != "Not an int";
+            }
+        }
+        CHECK(numBad == 0);
+    }
+
+    //Parsers that override validateArg never write; the legacy one does, under its lock
+    CHECK(count == -1 && d == -1 && s == "untouched" && ! b && custom == -1);
+    CHECK(legacy != -1);
+    CHECK(checked.numValidated == 4 * 10000);
+}
+
+TEST_CASE(batch, recordsMatchMessages){
+    CommandLineParser parser("app", "Batch test.");
+    int count = 0;
+    double d = 0;
+    parser.appendPositionalArgument(&count, "count");
+    parser.appendNamedArgument(&d, "-d", false);
+
+    std::vector<std::vector<std::string> > lines;
+    for(size_t i = 0; i < 5000; i++){
+        if(i % 2 == 0){
+            lines.push_back({"app", std::to_string(i), "-d", "1"});
+        }else{
+            lines.push_back({"app", std::to_string(i)});
+        }
+    }
+    std::vector<CommandLineParser::BatchResult> results;
+    ParseErrors records;
+    parser.parseBatch(lines, results, records, 4);
+    size_t numBad = 0;
+    for(size_t i = 0; i < lines.size(); i++){
+        if(i % 2 == 0){
+            numBad += results[i].status != CommandLineParser::SUCCESS;
+        }else{
+            numBad += results[i].numErrors != 1 ||
+                records[results[i].firstError].code != PARSE_ERR_UNMATCHED ||
+                records.message(results[i].firstError) !=
+                    "Did not match named argument: -d";
+        }
+    }
+    CHECK(numBad == 0);
+}
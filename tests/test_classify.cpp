@@ -0,0 +1,76 @@
+//Tests for classifyArgTokens(see ArgClassify.h).
+
+#include "Test.h"
+//--
+#include <cstdlib>
+#include <string_view>
+//--
+#include "ArgClassify.h"
+
+/// Views onto "strs," laid out back to back with a '\0' after each, the way argv is.
+class PackedTokens{
+public:
+    explicit PackedTokens(const std::vector<std::string>& strs){
+        for(size_t i = 0; i < strs.size(); i++){
+            buffer += strs[i];
+            buffer += '\0';
+        }
+        size_t at = 0;
+        for(size_t i = 0; i < strs.size(); i++){
+            views.push_back(std::string_view(buffer.data() + at, strs[i].size()));
+            at += strs[i].size() + 1;
+        }
+    }
+    std::string buffer;
+    std::vector<std::string_view> views;
+};
+
+static bool matchesOneAtATime(const std::vector<std::string_view>& views){
+    std::vector<uint8_t> classes(views.size(), 0xff);
+    classifyArgTokens(views.data(), views.size(), classes.data());
+    for(size_t i = 0; i < views.size(); i++){
+        if(classes[i] != classifyArgToken(views[i])){
+            std::cerr << "Token " << i << " \"" << views[i] << "\": " << (int)classes[i] <<
+                " instead of " << (int)classifyArgToken(views[i]) << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST_CASE(classify, backToBackTokensMatchOneAtATime){
+    const std::vector<std::string> strs = {"prog", "--name=value", "", "-5", "+.5",
+        "a long token that crosses a sixteen byte block", "=", "", "", "-h", "--help",
+        "tab\there", "x=y=z", std::string(40, 'q') + "=", "\xc3\xa9t\xc3\xa9", "-", "7", ""};
+    PackedTokens packed(strs);
+    CHECK(matchesOneAtATime(packed.views));
+
+    //Every window, so that runs start and end at every offset within a block
+    for(size_t first = 0; first < strs.size(); first++){
+        for(size_t last = first + 1; last <= strs.size(); last++){
+            std::vector<std::string_view> window(packed.views.begin() + first,
+                packed.views.begin() + last);
+            CHECK(matchesOneAtATime(window));
+        }
+    }
+}
+
+TEST_CASE(classify, randomTokensMatchOneAtATime){
+    srand(1);
+    const char alphabet[] = "ab-=.1 \x7f\x80";
+    for(int round = 0; round < 200; round++){
+        std::vector<std::string> strs(1 + rand() % 12);
+        for(size_t i = 0; i < strs.size(); i++){
+            strs[i].resize(rand() % 40);
+            for(size_t j = 0; j < strs[i].size(); j++){
+                strs[i][j] = alphabet[rand() % (sizeof(alphabet) - 1)];
+            }
+        }
+        PackedTokens packed(strs);
+        CHECK(matchesOneAtATime(packed.views));
+
+        //Tokens that are not back to back form runs of their own
+        std::vector<std::string_view> shuffled(packed.views.rbegin(), packed.views.rend());
+        CHECK(matchesOneAtATime(shuffled));
+    }
+}
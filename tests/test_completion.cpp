@@ -0,0 +1,80 @@
+//Tests for shell completion(CommandLineParser::printCompletions).
+
+#include "Test.h"
+//--
+#include <sstream>
+//--
+#include "CommandLineParser.h"
+#include "Subcommand.h"
+
+static std::string complete(const CommandLineParser& parser,
+    std::initializer_list<std::string_view> words){
+    std::ostringstream os;
+    parser.printCompletions(words.begin(), words.size(), os);
+    return os.str();
+}
+
+static bool offers(const std::string& out, const std::string& word){
+    return ("\n" + out).find("\n" + word + "\n") != std::string::npos;
+}
+
+/// "app [--verbose|-v] [--level <int>] <file> <mode>"
+struct FlagApp{
+    CommandLineParser parser;
+    uint64_t flags;
+    int level;
+    std::string file, mode;
+    FlagApp() : parser("app", "Completion test."), flags(0), level(0){
+        parser.appendFlagArgument(&flags, 0, "--verbose", 'v');
+        parser.appendNamedArgument(&level, "--level");
+        parser.appendPositionalArgument(&file, "file");
+        parser.appendPositionalArgument(&mode, "mode");
+        parser.setCompletionChoices("file", {"a.txt", "b.txt"});
+        parser.setCompletionChoices("mode", {"fast", "slow"});
+    }
+};
+
+TEST_CASE(completion, flagsAndTheirNegations){
+    FlagApp app;
+    CHECK(complete(app.parser, {"--ve"}) == "--verbose\n");
+    CHECK(complete(app.parser, {"--no"}) == "--no-verbose\n");
+    const std::string all = complete(app.parser, {"-"});
+    CHECK(offers(all, "--verbose") && offers(all, "--no-verbose") && offers(all, "-v") &&
+        offers(all, "--level"));
+}
+
+TEST_CASE(completion, flagsAreNotPositionalValues){
+    FlagApp app;
+    //Without skipping the flags, these would count as the two positional values
+    CHECK(complete(app.parser, {"--verbose", "a.txt", "f"}) == "fast\n");
+    CHECK(complete(app.parser, {"-v", "--no-verbose", ""}).find("a.txt") != std::string::npos);
+    CHECK(complete(app.parser, {"--level", "3", "--verbose", "b"}) == "b.txt\n");
+}
+
+class CountingCommand : public SubcommandFactory{
+public:
+    int numBuilt = 0;
+    int depth = 0;
+    virtual void buildParser(CommandLineParser& parser){
+        ++numBuilt;
+        parser.appendNamedArgument(&depth, "--depth");
+    }
+};
+
+TEST_CASE(completion, verbsAndTheirArguments){
+    CommandLineParser parser("app", "Completion test.");
+    std::string name;
+    CountingCommand clone, pull;
+    parser.appendNamedArgument(&name, "--name");
+    parser.appendSubcommand("clone", &clone);
+    parser.appendSubcommand("pull", &pull);
+
+    CHECK(complete(parser, {"cl"}) == "clone\n");
+    CHECK(complete(parser, {"--name", "n", "p"}) == "pull\n");
+    CHECK(complete(parser, {"--name", "cl"}) == ""); //The value of --name, not a verb
+    CHECK(clone.numBuilt == 0 && pull.numBuilt == 0);
+
+    //After the verb, its own arguments
+    CHECK(complete(parser, {"clone", "--de"}) == "--depth\n");
+    CHECK(clone.numBuilt == 1 && pull.numBuilt == 0);
+}
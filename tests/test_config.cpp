@@ -0,0 +1,117 @@
+//Tests for the config file fallback(CommandLineParser::setConfigFile).
+
+#include "Test.h"
+//--
+#include <cstdio>
+#include <fstream>
+#include <unistd.h>
+//--
+#include "CommandLineParser.h"
+#include "IncludedArgParsers.h"
+#include "LazyArg.h"
+
+/// A config file and its cache in the temporary directory, removed afterwards.
+class TempConfig{
+public:
+    explicit TempConfig(const std::string& text){
+        const std::string base = "/tmp/clp_test_config_" + std::to_string(getpid());
+        path      = base + ".conf";
+        cachePath = base + ".cache";
+        std::ofstream(path) << text;
+        remove(cachePath.c_str());
+    }
+    ~TempConfig(){
+        remove(path.c_str());
+        remove(cachePath.c_str());
+    }
+    std::string path;
+    std::string cachePath;
+};
+
+TEST_CASE(config, lazyAndListArgumentsFromFileAndCache){
+    TempConfig config("count = 3\nlazy = 42\nnums = 7\n");
+    //Once from the text(which writes the cache), then from the cache
+    for(int pass = 0; pass < 2; pass++){
+        CommandLineParser parser("app", "Config test.");
+        int count = 0;
+        LazyArg<int> lazy(parser.getCommonArgParser(CommandLineParser::AP_INT), -1);
+        std::vector<int> nums;
+        parser.appendNamedArgument(&count, "--count");
+        parser.appendLazyNamedArgument(&lazy, "--lazy");
+        parser.appendNamedListArgument(&nums, "--nums");
+        parser.setConfigFile(config.path, config.cachePath);
+
+        TestArgv args{"app"};
+        std::list<std::string> errs;
+        CHECK(parser.parse(args.argc(), args.argv(), errs) == CommandLineParser::SUCCESS);
+        CHECK(errs.empty());
+        CHECK(count == 3);
+        CHECK(lazy.get() == 42);
+        CHECK(nums.size() == 1 && nums[0] == 7);
+        CHECK(std::ifstream(config.cachePath).good());
+
+        //Checking the same command line in a batch goes through validateArg instead
+        std::vector<std::vector<std::string> > lines(4, std::vector<std::string>(1, "app"));
+        std::vector<CommandLineParser::BatchResult> results;
+        std::vector<std::string> batchErrs;
+        parser.parseBatch(lines, results, batchErrs, 2);
+        for(size_t i = 0; i < results.size(); i++){
+            CHECK(results[i].status == CommandLineParser::SUCCESS);
+        }
+    }
+}
+
+TEST_CASE(config, badLazyValueIsReported){
+    TempConfig config("lazy = x\n");
+    CommandLineParser parser("app", "Config test.");
+    LazyArg<int> lazy(parser.getCommonArgParser(CommandLineParser::AP_INT), -1);
+    parser.appendLazyNamedArgument(&lazy, "--lazy");
+    parser.setConfigFile(config.path, config.cachePath);
+
+    TestArgv args{"app"};
+    std::list<std::string> errs;
+    CHECK(parser.parse(args.argc(), args.argv(), errs) == CommandLineParser::SUCCESS);
+    CHECK(! parser.materializeLazyArguments(errs));
+    CHECK(lazy.get() == -1);
+}
+
+TEST_CASE(config, batchSharesOneLoadOfTheConfig){
+    TempConfig config("count = 3\nname = from config\n");
+    CommandLineParser parser("app", "Config test.");
+    int count = 0;
+    std::string name;
+    parser.appendNamedArgument(&count, "--count", false);
+    parser.appendNamedArgument(&name, "--name", false);
+    parser.setConfigFile(config.path, config.cachePath);
+
+    std::vector<std::vector<std::string> > lines;
+    for(size_t i = 0; i < 1000; i++){
+        switch(i % 3){
+            case 0:  lines.push_back({"app"}); break;
+            case 1:  lines.push_back({"app", "--count", "5"}); break;
+            default: lines.push_back({"app", "--count", "x"}); break;
+        }
+    }
+    std::vector<CommandLineParser::BatchResult> results;
+    std::vector<std::string> errors;
+    parser.parseBatch(lines, results, errors, 4);
+    size_t numBad = 0;
+    for(size_t i = 0; i < lines.size(); i++){
+        numBad += results[i].status != (i % 3 == 2 ? CommandLineParser::ERROR :
+            CommandLineParser::SUCCESS);
+    }
+    CHECK(numBad == 0);
+    CHECK(count == 0 && name.empty());
+
+    //A config file that can't be read fails every line that needs it, with the same message
+    remove(config.path.c_str());
+    parser.parseBatch(lines, results, errors, 4);
+    numBad = 0;
+    for(size_t i = 0; i < lines.size(); i++){
+        numBad += results[i].status != CommandLineParser::ERROR || results[i].numErrors != 1;
+        if(i % 3 != 2 && results[i].numErrors == 1){ //Lines 2, 5, ... fail on "x" first
+            numBad += errors[results[i].firstError] != "Could not open config file " + config.path;
+        }
+    }
+    CHECK(numBad == 0);
+}
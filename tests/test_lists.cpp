@@ -0,0 +1,56 @@
+//Tests for list arguments(appendNamedListArgument and ListArgParser).
+
+#include "Test.h"
+//--
+#include "CommandLineParser.h"
+#include "IncludedArgParsers.h"
+
+TEST_CASE(lists, badElementKeepsTheGoodPrefix){
+    CommandLineParser parser("app", "List test.");
+    std::vector<int> nums;
+    parser.appendNamedListArgument(&nums, "--nums");
+
+    TestArgv args{"app", "--nums", "1", "2", "x", "4"};
+    std::list<std::string> errs;
+    CHECK(parser.parse(args.argc(), args.argv(), errs) == CommandLineParser::ERROR);
+    CHECK(nums == std::vector<int>({1, 2}));
+    CHECK(! errs.empty());
+}
+
+TEST_CASE(lists, vectorOfBool){
+    CommandLineParser parser("app", "List test.");
+    std::vector<bool> bits;
+    parser.appendNamedListArgument(&bits, "--bits");
+
+    TestArgv args{"app", "--bits", "true", "false", "true"};
+    std::list<std::string> errs;
+    CHECK(parser.parse(args.argc(), args.argv(), errs) == CommandLineParser::SUCCESS);
+    CHECK(bits == std::vector<bool>({true, false, true}));
+
+    TestArgv bad{"app", "--bits", "true", "maybe"};
+    CHECK(parser.parse(bad.argc(), bad.argv(), errs) == CommandLineParser::ERROR);
+    CHECK(bits == std::vector<bool>({true}));
+}
+
+TEST_CASE(lists, nameAsTheLastTokenIsAnEmptyList){
+    CommandLineParser parser("app", "List test.");
+    std::vector<int> nums;
+    int other = 0;
+    parser.appendNamedListArgument(&nums, "--nums");
+    parser.appendNamedArgument(&other, "--other");
+
+    std::list<std::string> errs;
+    nums.push_back(9);
+    TestArgv last{"app", "--nums"};
+    CHECK(parser.parse(last.argc(), last.argv(), errs) == CommandLineParser::SUCCESS);
+    CHECK(nums.empty() && errs.empty());
+
+    nums.push_back(9);
+    TestArgv followed{"app", "--nums", "--other", "3"};
+    CHECK(parser.parse(followed.argc(), followed.argv(), errs) == CommandLineParser::SUCCESS);
+    CHECK(nums.empty() && other == 3 && errs.empty());
+
+    //Other names still need a value
+    TestArgv noValue{"app", "--nums", "1", "--other"};
+    CHECK(parser.parse(noValue.argc(), noValue.argv(), errs) == CommandLineParser::ERROR);
+}
@@ -0,0 +1,35 @@
+//Tests for the constraints on arguments(CommandLineParser::setRange, addDependency and addExclusion).
+
+#include "Test.h"
+//--
+#include "CommandLineParser.h"
+
+TEST_CASE(rules, rangedValuesAreStoredWithTheirOwnType){
+    CommandLineParser parser("app", "Rules test.");
+    //Guards around each variable catch a store of the wrong size
+    struct{ float before; float f; float after; } f = {-1, 0, -1};
+    struct{ unsigned before; unsigned u; unsigned after; } u = {7, 0, 7};
+    struct{ int before; int i; int after; } i = {7, 0, 7};
+    struct{ double before; double d; double after; } d = {-1, 0, -1};
+    parser.appendNamedArgument(&f.f, "-f");
+    parser.appendNamedArgument(&u.u, "-u");
+    parser.appendNamedArgument(&i.i, "-i");
+    parser.appendNamedArgument(&d.d, "-d");
+    CHECK(parser.setRange("-f", 0, 1));
+    CHECK(parser.setRange("-u", 1, 100));
+    CHECK(parser.setRange("-i", -5, 5));
+    CHECK(parser.setRange("-d", 0, 1));
+
+    TestArgv args{"app", "-f", "0.5", "-u", "42", "-i", "-3", "-d", "0.25"};
+    std::list<std::string> errs;
+    CHECK(parser.parse(args.argc(), args.argv(), errs) == CommandLineParser::SUCCESS);
+    CHECK(f.f == 0.5f && f.before == -1 && f.after == -1);
+    CHECK(u.u == 42 && u.before == 7 && u.after == 7);
+    CHECK(i.i == -3 && i.before == 7 && i.after == 7);
+    CHECK(d.d == 0.25 && d.before == -1 && d.after == -1);
+
+    //Out of range values are never stored
+    TestArgv bad{"app", "-f", "1.5"};
+    CHECK(parser.parse(bad.argc(), bad.argv(), errs) == CommandLineParser::ERROR);
+    CHECK(f.f == 0.5f);
+}
@@ -0,0 +1,94 @@
+//Tests for parse snapshots(CommandLineParser::writeSnapshot and loadSnapshot).
+
+#include "Test.h"
+//--
+#include <cstdio>
+#include <fstream>
+#include <unistd.h>
+//--
+#include "CommandLineParser.h"
+#include "Subcommand.h"
+
+/// A snapshot written to the temporary directory, removed afterwards.
+class TempSnapshot{
+public:
+    explicit TempSnapshot(const std::string& bytes) :
+        path("/tmp/clp_test_snapshot_" + std::to_string(getpid())){
+        std::ofstream(path, std::ios::binary) << bytes;
+    }
+    ~TempSnapshot(){ remove(path.c_str()); }
+    std::string path;
+};
+
+/// The flags test parser: "-n <int>" and a flag "--verbose" on bit "bit."
+struct FlagApp{
+    CommandLineParser parser;
+    int n;
+    uint64_t flags;
+    explicit FlagApp(size_t bit) : parser("app", "Snapshot test."), n(0), flags(0){
+        parser.appendNamedArgument(&n, "-n");
+        parser.appendFlagArgument(&flags, bit, "--verbose");
+        parser.setSnapshotOption("--from-snapshot");
+    }
+};
+
+TEST_CASE(snapshot, flagBitsArePartOfTheFingerprint){
+    FlagApp writer(0);
+    TestArgv args{"app", "-n", "5", "--verbose"};
+    std::string bytes;
+    std::list<std::string> errs;
+    CHECK(writer.parser.writeSnapshot(args.argc(), args.argv(), bytes, errs) ==
+        CommandLineParser::SUCCESS);
+    TempSnapshot snapshot(bytes);
+
+    //Same layout: the snapshot is used and the rest of argv is ignored
+    FlagApp same(0);
+    TestArgv load{"app", "--from-snapshot", snapshot.path, "-n", "7"};
+    CHECK(same.parser.parse(load.argc(), load.argv(), errs) == CommandLineParser::SUCCESS);
+    CHECK(same.n == 5 && same.flags == 1);
+
+    //The flag moved to another bit: the snapshot is refused and argv is parsed instead
+    FlagApp moved(3);
+    CHECK(moved.parser.schemaFingerprint() != writer.parser.schemaFingerprint());
+    std::string err;
+    CHECK(! moved.parser.loadSnapshot(snapshot.path, err));
+    CHECK(moved.parser.parse(load.argc(), load.argv(), errs) == CommandLineParser::SUCCESS);
+    CHECK(moved.n == 7 && moved.flags == 0);
+    CHECK(errs.empty());
+}
+
+/// Every verb gets the same arguments, so only the verb list tells the parsers apart.
+class CountCommand : public SubcommandFactory{
+public:
+    int count = 0;
+    virtual void buildParser(CommandLineParser& parser){
+        parser.appendNamedArgument(&count, "-count");
+    }
+};
+
+TEST_CASE(snapshot, verbsArePartOfTheFingerprint){
+    CountCommand pull, clone;
+    std::string verb;
+    CommandLineParser writer("app", "Snapshot test.");
+    writer.appendSubcommand("pull", &pull);
+    writer.appendSubcommand("clone", &clone);
+    TestArgv args{"app", "clone", "-count", "2"};
+    std::string bytes;
+    std::list<std::string> errs;
+    CHECK(writer.writeSnapshot(args.argc(), args.argv(), bytes, errs) ==
+        CommandLineParser::SUCCESS);
+    TempSnapshot snapshot(bytes);
+
+    //The verbs swapped places, so the snapshot's "second verb" would now mean pull
+    CountCommand pull2, clone2;
+    CommandLineParser reader("app", "Snapshot test.");
+    reader.appendSubcommand("clone", &clone2);
+    reader.appendSubcommand("pull", &pull2);
+    reader.setSubcommandVariable(&verb);
+    reader.setSnapshotOption("--from-snapshot");
+    CHECK(reader.schemaFingerprint() != writer.schemaFingerprint());
+
+    TestArgv load{"app", "--from-snapshot", snapshot.path, "clone", "-count", "9"};
+    CHECK(reader.parse(load.argc(), load.argv(), errs) == CommandLineParser::SUCCESS);
+    CHECK(verb == "clone" && clone2.count == 9 && pull2.count == 0);
+}
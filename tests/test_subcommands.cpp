@@ -0,0 +1,75 @@
+//Tests for subcommands(CommandLineParser::appendSubcommand).
+
+#include "Test.h"
+//--
+#include <sstream>
+//--
+#include "CommandLineParser.h"
+#include "Subcommand.h"
+
+class CloneCommand : public SubcommandFactory{
+public:
+    std::string url;
+    virtual void buildParser(CommandLineParser& parser){
+        parser.appendPositionalArgument(&url, "url", "Repository to clone.");
+    }
+};
+
+/// "app [--name <string>] clone <url>"
+struct VerbApp{
+    CommandLineParser parser;
+    std::string name;
+    CloneCommand clone;
+    VerbApp() : parser("app", "The parent tool."){
+        parser.appendNamedArgument(&name, "--name");
+        parser.appendSubcommand("clone", &clone, "Clone a repository.");
+    }
+    CommandLineParser::ParseDoneStatus parse(TestArgv args, std::string& out,
+        std::list<std::string>& errs){
+        std::ostringstream os;
+        const CommandLineParser::ParseDoneStatus status =
+            parser.parse(args.argc(), args.argv(), errs, os);
+        out = os.str();
+        return status;
+    }
+};
+
+TEST_CASE(subcommands, helpBeforeTheVerbIsForTheParent){
+    VerbApp app;
+    std::string out;
+    std::list<std::string> errs;
+    CHECK(app.parse({"app", "--help", "clone", "x"}, out, errs) ==
+        CommandLineParser::HELP_PRINTED);
+    CHECK(out.find("The parent tool.") != std::string::npos && errs.empty());
+
+    //"clone" is the value of --name here, not the verb
+    CHECK(app.parse({"app", "--name", "clone", "--help"}, out, errs) ==
+        CommandLineParser::HELP_PRINTED);
+    CHECK(out.find("The parent tool.") != std::string::npos && errs.empty());
+
+    CHECK(app.parse({"app", "--name", "--help", "clone", "x"}, out, errs) ==
+        CommandLineParser::HELP_PRINTED);
+    CHECK(out.find("The parent tool.") != std::string::npos && errs.empty());
+}
+
+TEST_CASE(subcommands, helpAfterTheVerbIsForTheVerb){
+    VerbApp app;
+    std::string out;
+    std::list<std::string> errs;
+    CHECK(app.parse({"app", "--name", "n", "clone", "--help"}, out, errs) ==
+        CommandLineParser::HELP_PRINTED);
+    CHECK(out.find("Clone a repository.") != std::string::npos);
+    CHECK(out.find("The parent tool.") == std::string::npos);
+    CHECK(errs.empty());
+
+    CHECK(app.parse({"app", "--name", "clone", "clone", "repo"}, out, errs) ==
+        CommandLineParser::SUCCESS);
+    CHECK(app.name == "clone" && app.clone.url == "repo" && errs.empty());
+
+    //The parent fails before it gets to a verb(--id is missing), so the help is its own
+    VerbApp strict;
+    std::string id;
+    strict.parser.appendNamedArgument(&id, "--id", false);
+    CHECK(strict.parse({"app", "clone", "--help"}, out, errs) == CommandLineParser::HELP_PRINTED);
+    CHECK(out.find("The parent tool.") != std::string::npos && errs.empty());
+}